@@ -0,0 +1,39 @@
+/*!
+ * @file    calibration.h
+ * @author  Tyler Holmes
+ * @date    16-Oct-2026
+ * @brief   Per-unit calibration record, kept in its own flash sector.
+ */
+#pragma once
+
+#include <stdint.h>
+
+#include "common.h"
+
+/*! Sector the record lives in, and where that is. The linker script keeps it
+ *   out of FLASH, so erasing it never takes code with it.
+ */
+#define CAL_FLASH_SECTOR  (FLASH_SECTOR_7)
+#define CAL_FLASH_ADDR    (0x08060000UL)
+
+#define CAL_MAGIC    (0x4C414354UL)  //!< "TCAL"
+#define CAL_VERSION  (1)
+
+
+/*! Two-point calibration of one unit's amp, as stored. Applied to the q16
+ *   vout / vref ratio before the conversion table, as ratio * gain + offset
+ *   (see `therm_setCalibration`).
+ */
+typedef struct {
+    uint32_t magic;     //!< `CAL_MAGIC`, so a blank or foreign sector isn't taken for a record
+    uint16_t version;   //!< `CAL_VERSION` of the layout
+    uint16_t reserved;
+    int32_t gain;       //!< q`THERM_CAL_GAIN_SHIFT`
+    int32_t offset;     //!< q16 ratio
+    uint32_t crc;       //!< CRC-32 of everything above
+} cal_record_t;
+
+
+ret_t cal_load(cal_record_t * record);
+ret_t cal_store(cal_record_t * record);
+uint32_t cal_crc32(const void * data, uint32_t length);
@@ -0,0 +1,60 @@
+/*!
+ * @file    cycle.h
+ * @author  Tyler Holmes
+ * @date    16-Oct-2026
+ * @brief   Spots the oven thermostat cycling the element on and off.
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "common.h"
+#include "tables.h"  // block length and bins, with their Goertzel and window tables
+
+//! Readings averaged into each sample the detector looks at
+#define CYCLE_DECIMATION  (4)
+//! Blocks running at once, staggered so a new estimate lands every quarter block
+#define CYCLE_BANKS       (4)
+
+
+//! One block's worth of Goertzel filters, one per bin.
+typedef struct {
+    float s1[CYCLE_BINS];  //!< last filter output per bin
+    float s2[CYCLE_BINS];  //!< the one before that
+    int32_t offset;        //!< first sample of the block, taken off the rest to keep the floats small
+    int64_t sum;           //!< sum of the block's samples, for its mean
+    int16_t n;             //!< samples into the block. Negative while waiting to start
+} cycle_bank_t;
+
+/*! Cycle detector. Readings are pushed in at a steady rate, averaged in fours,
+ *   and run through a bank of Goertzel filters (Hann windowed) covering
+ *   periods of `CYCLE_BLOCK / CYCLE_MAX_BIN` to `CYCLE_BLOCK / CYCLE_MIN_BIN`
+ *   samples. Each push costs one multiply-add per bin per bank; the spectrum
+ *   is only looked at when a block finishes.
+ */
+typedef struct {
+    cycle_bank_t banks[CYCLE_BANKS];
+    int32_t history[CYCLE_BLOCK];  //!< the last block of samples, for the mean across cycles
+    uint16_t head;         //!< where the next sample goes in `history`
+    uint16_t count;        //!< valid samples in `history`
+    int32_t dec_sum;       //!< readings summed towards the next sample
+    uint8_t dec_count;     //!< readings in `dec_sum`
+    uint32_t sample_ms;    //!< time between pushed readings
+    uint32_t period_ms;    //!< last period found, 0 if none
+    int32_t amplitude;     //!< last swing found (the fundamental's peak), centi-degrees
+    int32_t block_mean;    //!< mean of the last finished block
+    bool have_block;       //!< `block_mean` is valid
+    bool cycling;          //!< the last block had a clear cycle in it
+    bool steady;           //!< the last two blocks agreed on it
+} cycle_t;
+
+
+ret_t cycle_init(cycle_t * cycle, uint32_t sample_ms);
+void cycle_reset(cycle_t * cycle);
+void cycle_push(cycle_t * cycle, int32_t temp);
+
+bool cycle_steady(const cycle_t * cycle);
+uint32_t cycle_period_ms(const cycle_t * cycle);
+int32_t cycle_amplitude(const cycle_t * cycle);
+int32_t cycle_mean(const cycle_t * cycle);
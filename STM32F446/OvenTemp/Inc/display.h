@@ -9,8 +9,18 @@
 #include <stdint.h>
 #include <stdbool.h>
 
+#include "common.h"
+#include "render.h"
+
 #define DISP_I2C_ADDR  (0x70 << 1)
 
+//! I2C transfers (frames and commands) that can be waiting to go out. Must be a power of 2.
+#define DISP_QUEUE_LEN  (4)
+//! 16 bit words of HT16K33 display RAM
+#define DISP_WORDS  (8)
+//! Bytes in a whole frame: the RAM address to start at, then every display word
+#define DISP_FRAME_BYTES  (1 + 2 * DISP_WORDS)
+
 #define LED_ON 1
 #define LED_OFF 0
 
@@ -41,7 +51,14 @@ void disp_clear(void);
 void disp_writeDigit_raw(uint8_t n, uint16_t bitmask);
 void disp_writeDigit_value(uint8_t n, uint8_t number, bool point);
 void disp_writeDigit_ascii(uint8_t n, uint8_t character, bool point);
+void disp_writeFrame(const render_frame_t * frame);
 void disp_writeDisplay(void);
+bool disp_busy(void);
+ret_t disp_flush(uint32_t timeout_ms);
+uint32_t disp_droppedCount(void);
+uint32_t disp_framesSubmitted(void);
+uint32_t disp_framesSent(void);
+uint32_t disp_errorCount(void);
 
 
 /***************************************************
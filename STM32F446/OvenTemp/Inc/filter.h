@@ -0,0 +1,60 @@
+/*!
+ * @file    filter.h
+ * @author  Tyler Holmes
+ * @date    16-Oct-2026
+ * @brief   Block IIR filter stage built on the CMSIS-DSP q31 biquad cascade.
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "common.h"
+#include "stm32f4xx_hal.h"  // device header first, arm_math.h needs it for core_cm4.h
+#include "arm_math.h"
+
+//! Most biquads (second order sections) a `filter_t` can cascade
+#define FILTER_MAX_STAGES  (4)
+//! Coefficients per biquad: b0, b1, b2, a1, a2 (CMSIS order, a's negated)
+#define FILTER_COEFFS_PER_STAGE  (5)
+//! Fractional bits integer samples get shifted up by on their way through
+#define FILTER_FRAC_BITS  (12)
+//! Largest decimation factor (and FIR length) a `filter_decim_t` can do
+#define FILTER_DECIM_MAX_FACTOR  (16)
+
+
+/*! A cascade of up to `FILTER_MAX_STAGES` biquads run over blocks of integer
+ *   samples. Samples are shifted up by `FILTER_FRAC_BITS` going in so rounding
+ *   in the filter doesn't eat into them, which limits them to +/- 2^19.
+ */
+typedef struct {
+    arm_biquad_casd_df1_inst_q31 inst;
+    q31_t coeffs[FILTER_MAX_STAGES * FILTER_COEFFS_PER_STAGE];
+    q31_t state[FILTER_MAX_STAGES * 4];
+    uint8_t num_stages;  //!< 0 means samples pass straight through
+    bool primed;         //!< false until the state has been set from a sample
+} filter_t;
+
+/*! Boxcar FIR decimator: every `factor` samples are averaged down to one. Run
+ *   at `factor` samples per cycle of some interference, its zeros land right
+ *   on that frequency and all of its harmonics. Same scaling as `filter_t`.
+ *   The taps aren't copied, so they need to outlive it.
+ */
+typedef struct {
+    arm_fir_decimate_instance_q31 inst;
+    q31_t state[2 * FILTER_DECIM_MAX_FACTOR - 1];  //!< taps + block - 1, as CMSIS wants
+    q31_t pending[FILTER_DECIM_MAX_FACTOR];  //!< input waiting for a full block
+    uint8_t factor;       //!< 0 means samples pass straight through
+    uint8_t num_pending;  //!< samples in `pending`
+    bool primed;          //!< false until the history has been set from a sample
+} filter_decim_t;
+
+
+ret_t filter_init(filter_t * filter, const q31_t * coeffs, uint8_t num_stages, uint8_t post_shift);
+void filter_reset(filter_t * filter);
+void filter_process(filter_t * filter, int32_t * samples, uint32_t num_samples);
+bool filter_enabled(const filter_t * filter);
+
+ret_t filter_decimInit(filter_decim_t * decim, const q31_t * taps, uint8_t factor);
+void filter_decimReset(filter_decim_t * decim);
+uint32_t filter_decimProcess(filter_decim_t * decim, int32_t * samples, uint32_t num_samples);
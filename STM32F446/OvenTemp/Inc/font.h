@@ -0,0 +1,20 @@
+/*!
+ * @file    font.h
+ * @author  Tyler Holmes
+ * @date    16-Oct-2026
+ * @brief   14 segment font for the quad alphanumeric display, from the adafruit LED Backpack code.
+ *
+ *      Kept out of display.c so the renderer can build glyph words without
+ *      pulling in the HAL.
+ */
+#pragma once
+
+#include <stdint.h>
+
+//! Characters in the font, ASCII 0 to 127
+#define FONT_CHARS  (128)
+//! Segment that lights a digit's decimal point
+#define FONT_POINT_MASK  (1 << 14)
+
+
+extern const uint16_t alphafonttable[FONT_CHARS];
@@ -12,8 +12,50 @@
 #include "stm32f4xx_hal.h"
 #include "common.h"
 
+/*! Convert vout on ADC1 and vref on ADC2 at the same instant (dual regular
+ *   simultaneous mode) instead of one after the other on ADC1. Takes half the
+ *   time and the ratio isn't skewed by anything moving between the two.
+ *   Either way vout and vref land in memory as pairs, see `ADC_SCAN_VOUT`.
+ */
+#define ADC_SIMULTANEOUS  (1)
+
+/*! Set to 1 to convert the STM32's internal temperature sensor in every scan
+ *   as well, for cold junction compensation. It rides along in the same
+ *   sequence and DMA transfer, so it costs no extra wakeups. The sensor is
+ *   only on ADC1, and in simultaneous mode both sequences have to be the
+ *   same length, so ADC2 converts vref again alongside it.
+ */
+#define ADC_SCAN_DIE_TEMP  (1)
+
+//! Where each channel lands in a scan, and how many conversions a scan is
+#define ADC_SCAN_VOUT  (0)
+#if ADC_SCAN_DIE_TEMP && ADC_SIMULTANEOUS
+#define ADC_SCAN_VREF  (1)
+#define ADC_SCAN_DIE   (2)
+#define NUM_ADC_CHANNELS  (4)  //!< vout, vref, die temperature, vref again
+#elif ADC_SCAN_DIE_TEMP
+#define ADC_SCAN_DIE   (1)
+#define ADC_SCAN_VREF  (2)
+#define NUM_ADC_CHANNELS  (3)  //!< vout, die temperature, vref (last, for `hw_ADC_getVref`)
+#else
+#define ADC_SCAN_VREF  (1)
 #define NUM_ADC_CHANNELS  (2)  //!< Thermocouple vout and voltage ref
+#endif
+
+//! Analog front end (thermocouple amp and reference) enable. Active low, on D10
+//!   of the Arduino header, same as the prototype.
+#define AFE_EN_PORT  (GPIOB)
+#define AFE_EN_PIN   (GPIO_PIN_6)
 
+//! Tick rate of TIM2 after prescaling. Sets the resolution of the sample clock.
+#define TIM2_TICK_HZ  (1000000UL)
+
+
+//! What kicks off a scan of the ADC channels.
+typedef enum {
+    kADCTrigger_Software,  //!< Firmware starts each scan
+    kADCTrigger_Timer,     //!< TIM2 TRGO starts each scan at a fixed rate
+} adc_trigger_t;
 
 //! Enum of the timing pins we use.
 typedef enum {
@@ -26,6 +68,15 @@ void SystemClock_Config(void);
 void hw_GPIO_Init(void);
 void hw_DMA_Init(void);
 void hw_ADC1_Init(void);
+void hw_ADC2_Init(void);
+void hw_ADC1_setTrigger(adc_trigger_t trigger);
+void hw_ADC1_setWatchdog(bool enable, uint16_t high_threshold);
+HAL_StatusTypeDef hw_ADC_startDMA(uint16_t * dest, uint32_t num_scans, bool half_transfer);
+void hw_ADC_stopDMA(void);
+uint16_t hw_ADC_getVref(void);
+void hw_ADC_setPower(bool on);
+void hw_AFE_setPower(bool on);
+void hw_TIM2_Init(void);
 void hw_I2C3_Init(void);
 void hw_RTC_Init(void);
 void hw_UART4_Init(void);
@@ -33,6 +84,9 @@ void hw_NVIC_Init(void);
 
 void hw_RTC_setWakeup(uint32_t timeToWake_ms);
 
+ret_t hw_TIM2_start(uint32_t rate_hz);
+void hw_TIM2_stop(void);
+
 void hw_LED_setValue(uint8_t value);
 void hw_LED_toggle(void);
 
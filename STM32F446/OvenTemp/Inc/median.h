@@ -0,0 +1,54 @@
+/*!
+ * @file    median.h
+ * @author  Tyler Holmes
+ * @date    16-Oct-2026
+ * @brief   Sliding window median / Hampel spike rejection.
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "common.h"
+
+//! Largest window a `median_t` can track
+#define MEDIAN_MAX_WINDOW  (31)
+//! Skip list levels, log2 of one past the largest window
+#define MEDIAN_LEVELS  (5)
+//! Link past the last node of the skip list
+#define MEDIAN_NIL  (0xFF)
+
+
+/*! One sample in the window's skip list. Each link also says how many samples
+ *   it jumps over, so walking down to the k-th smallest is as quick as a
+ *   search.
+ */
+typedef struct {
+    int32_t value;
+    uint8_t next[MEDIAN_LEVELS];   //!< next node at each level, `MEDIAN_NIL` past the end
+    uint8_t width[MEDIAN_LEVELS];  //!< samples each link steps over
+    uint8_t levels;                //!< how many levels this node is linked into
+} median_node_t;
+
+/*! Hampel filter over the last `window` samples, kept in an indexable skip
+ *   list so adding, aging out and looking up the median or a quartile are
+ *   all O(log n). Ring slot i of the window is node i + 1, so the oldest
+ *   sample's node is known without searching for it. Node 0 is the head.
+ */
+typedef struct {
+    median_node_t nodes[MEDIAN_MAX_WINDOW + 1];
+    uint32_t random;          //!< xorshift state for picking node levels
+    uint16_t window;          //!< length of the window, 0 for pass through
+    uint16_t count;           //!< valid samples in the window
+    uint16_t head;            //!< ring slot the next sample goes in, oldest once full
+    uint16_t threshold;       //!< how far out a sample is an outlier, in tenths of sigma
+    int32_t min_deviation;    //!< samples this close to the median always pass
+    uint32_t rejected;        //!< outliers replaced so far
+} median_t;
+
+
+ret_t median_init(median_t * filter, uint16_t window, uint16_t threshold_tenths, int32_t min_deviation);
+void median_reset(median_t * filter);
+int32_t median_filter(median_t * filter, int32_t sample);
+int32_t median_get(const median_t * filter);
+uint32_t median_rejected(const median_t * filter);
@@ -0,0 +1,50 @@
+/*!
+ * @file    preheat.h
+ * @author  Tyler Holmes
+ * @date    16-Oct-2026
+ * @brief   Preheat ETA from a sliding least squares fit of recent readings.
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "common.h"
+
+//! Most readings a `preheat_t` fits a line through
+#define PREHEAT_MAX_WINDOW  (32)
+//! Fewest readings before we'll guess at an ETA
+#define PREHEAT_MIN_POINTS  (4)
+
+
+//! One reading in the fit.
+typedef struct {
+    int32_t time;  //!< deciseconds since the fit was reset
+    int32_t temp;  //!< centi-degrees
+} preheat_point_t;
+
+/*! Least squares line through the last `window` readings. Keeps running sums
+ *   as readings enter and leave the window, so adding one is O(1), as is
+ *   working out the fit. Times are kept in deciseconds so the sums stay well
+ *   inside 64 bits for hours of heating.
+ */
+typedef struct {
+    preheat_point_t points[PREHEAT_MAX_WINDOW];  //!< circular buffer of the window
+    uint16_t window;   //!< length of the window, in readings
+    uint16_t count;    //!< valid readings in the window
+    uint16_t head;     //!< where the next reading goes
+    uint32_t start_tick;  //!< HAL tick times are measured from
+    int64_t sum_t;
+    int64_t sum_y;
+    int64_t sum_tt;
+    int64_t sum_ty;
+    int64_t sum_yy;
+} preheat_t;
+
+
+ret_t preheat_init(preheat_t * fit, uint16_t window);
+void preheat_reset(preheat_t * fit);
+void preheat_push(preheat_t * fit, uint32_t tick, int32_t temp);
+int32_t preheat_rate(const preheat_t * fit);
+ret_t preheat_eta(const preheat_t * fit, int32_t target, uint32_t tick,
+                  uint32_t * eta_s, uint8_t * confidence);
@@ -0,0 +1,52 @@
+/*!
+ * @file    render.h
+ * @author  Tyler Holmes
+ * @date    16-Oct-2026
+ * @brief   Turns fixed point temperatures into digits for the quad alphanumeric display.
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+//! Digits on the display
+#define RENDER_DIGITS  (4)
+//! Highest reading that fits, 999.9 (the hundredths get dropped up there)
+#define RENDER_MAX_CENTI  (99999UL)
+
+/*! Set to 1 to also build `render_float`, the float way `displayTemp` used to
+ *   work out its digits, and time the two at boot (`make DEBUG=1
+ *   RENDER_BENCHMARK=1`). Off otherwise, even for DEBUG.
+ */
+#ifndef RENDER_BENCHMARK
+#define RENDER_BENCHMARK  (0)
+#endif
+
+
+/*! A rendered reading: the display words for each digit, straight from the
+ *   font with the decimal point already lit, so `disp_writeFrame` only has to
+ *   copy them.
+ */
+typedef struct {
+    uint16_t glyphs[RENDER_DIGITS];  //!< display words, 0 for a blank digit
+    uint8_t point;                   //!< digit the decimal point goes after
+} render_frame_t;
+
+
+/*! Deadband on a value about to be rendered. What's shown only moves once a
+ *   new value is `band` or more away from it, so noise smaller than that
+ *   doesn't flip the last digit back and forth.
+ */
+typedef struct {
+    int32_t shown;  //!< value last let through
+    int32_t band;   //!< how far a value has to move to be let through
+    bool valid;     //!< `shown` has been set
+} render_deadband_t;
+
+
+void render_centi(uint32_t centi, render_frame_t * frame);
+void render_deadbandInit(render_deadband_t * deadband, int32_t band);
+int32_t render_deadband(render_deadband_t * deadband, int32_t value);
+#if RENDER_BENCHMARK
+void render_float(float temp, render_frame_t * frame);
+#endif
@@ -0,0 +1,41 @@
+/*!
+ * @file    sample_queue.h
+ * @author  Tyler Holmes
+ * @date    16-Oct-2026
+ * @brief   Lock-free single-producer / single-consumer queue of ADC samples.
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+//! Number of records the queue holds. Must be a power of 2.
+#define SAMPLEQ_LEN  (64)
+
+
+//! One timestamped, decimated sample of the thermocouple channels.
+typedef struct {
+    uint32_t seq;        //!< running sample count, to spot drops
+    uint32_t timestamp;  //!< HAL tick (ms) when the sample's block finished
+    uint16_t vout;       //!< thermocouple amp output, in ADC counts
+    uint16_t vref;       //!< 1.25 V reference, in ADC counts
+    uint16_t die;        //!< STM32 die temperature sensor, in ADC counts. 0 if not scanned
+} therm_sample_t;
+
+/*! Ring of samples shared between exactly one producer (the ADC interrupt) and
+ *   one consumer (the main loop). Each side only ever writes its own index, so
+ *   no locks or disabled interrupts are needed.
+ */
+typedef struct {
+    therm_sample_t records[SAMPLEQ_LEN];
+    volatile uint32_t head;     //!< free running write count. Producer only
+    volatile uint32_t tail;     //!< free running read count. Consumer only
+    volatile uint32_t dropped;  //!< samples thrown away because it was full. Producer only
+} sampleq_t;
+
+
+void sampleq_init(sampleq_t * q);
+bool sampleq_push(sampleq_t * q, const therm_sample_t * sample);
+uint32_t sampleq_pop(sampleq_t * q, therm_sample_t * out, uint32_t max_samples);
+uint32_t sampleq_count(const sampleq_t * q);
+uint32_t sampleq_dropped(const sampleq_t * q);
@@ -0,0 +1,58 @@
+/*!
+ * @file    stats.h
+ * @author  Tyler Holmes
+ * @date    16-Oct-2026
+ * @brief   Streaming statistics over a sliding window of integer samples.
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "common.h"
+
+//! Largest window a `stats_t` can track
+#define STATS_MAX_WINDOW  (64)
+
+
+//! One entry of the min / max tracking queues.
+typedef struct {
+    uint32_t seq;   //!< sequence number of the sample, to know when it ages out
+    int32_t value;  //!< the sample itself
+} stats_entry_t;
+
+//! Monotonic queue that keeps the min (or max) of the window at its head.
+typedef struct {
+    stats_entry_t entries[STATS_MAX_WINDOW];
+    uint16_t head;  //!< index of the oldest entry, the current min / max
+    uint16_t len;   //!< number of valid entries
+} stats_extreme_t;
+
+/*! Running statistics over the last `window` samples. Keeps running sums as
+ *   samples enter and leave the window, so pushing a sample and every query
+ *   are O(1) (min / max are amortized O(1)).
+ */
+typedef struct {
+    int32_t samples[STATS_MAX_WINDOW];  //!< circular buffer of the window
+    uint16_t window;  //!< length of the window, in samples
+    uint16_t count;   //!< valid samples in the window
+    uint16_t head;    //!< where the next sample goes
+    uint32_t seq;     //!< sequence number of the next sample
+    int64_t sum;      //!< sum of all samples in the window
+    int64_t sum_sq;   //!< sum of the squares of all samples in the window
+    stats_extreme_t min;
+    stats_extreme_t max;
+} stats_t;
+
+
+ret_t stats_init(stats_t * stats, uint16_t window);
+void stats_reset(stats_t * stats);
+void stats_push(stats_t * stats, int32_t value);
+
+uint16_t stats_count(const stats_t * stats);
+bool stats_full(const stats_t * stats);
+int32_t stats_latest(const stats_t * stats);
+int32_t stats_mean(const stats_t * stats);
+uint32_t stats_variance(const stats_t * stats);
+int32_t stats_min(const stats_t * stats);
+int32_t stats_max(const stats_t * stats);
@@ -0,0 +1,53 @@
+/*!
+ * @file    tables.h
+ * @author  Tyler Holmes
+ * @date    16-Oct-2026
+ * @brief   Constant tables generated from the calibration description.
+ *
+ *      Generated by scripts/gen_tables.py from scripts/calibration.json. Don't edit,
+ *      change the description and run `make tables` instead.
+ */
+#pragma once
+
+#include <stdint.h>
+
+//! Fractional bits of the vout / vref ratio `therm_ratio_lut` is indexed by
+#define THERM_RATIO_FRAC_BITS  (16)
+/*! `therm_ratio_lut` covers -20 to 410 C in segments of
+ *   2^`THERM_LUT_SEGMENT_SHIFT` of ratio, starting at `THERM_LUT_RATIO_START`.
+ */
+#define THERM_LUT_RATIO_START    (59392UL)
+#define THERM_LUT_SEGMENT_SHIFT  (11)
+#define THERM_LUT_SIZE           (57)
+
+//! Cold junction temperature `therm_ratio_lut` was made for, in centi-degrees
+#define THERM_COLD_JUNCTION_CC  (2500)
+//! `therm_cjc_ratio` starts at `THERM_CJC_START_CC` and steps by `THERM_CJC_STEP_CC`
+#define THERM_CJC_START_CC  (0)
+#define THERM_CJC_STEP_CC   (1000)
+#define THERM_CJC_SIZE      (9)
+
+//! Raw 12 bit counts of the 1.25 V reference on a 3.3 V supply. Used until we've seen one.
+#define THERM_NOMINAL_VREF_COUNTS  (1551)
+
+//! Samples per mains cycle, and how many get decimated down to one
+#define THERM_MAINS_SAMPLES_PER_CYCLE  (8)
+
+//! Biquads in `therm_smoothing_filter`, and the post shift they're scaled by
+#define THERM_SMOOTHING_STAGES  (1)
+#define THERM_SMOOTHING_SHIFT   (1)
+
+//! Samples in each Goertzel block
+#define CYCLE_BLOCK       (128)
+//! Lowest and highest Goertzel bins, in cycles per block
+#define CYCLE_MIN_BIN     (2)
+#define CYCLE_MAX_BIN     (16)
+#define CYCLE_BINS        (CYCLE_MAX_BIN - CYCLE_MIN_BIN + 1)
+
+
+extern const int32_t therm_ratio_lut[THERM_LUT_SIZE];
+extern const int32_t therm_cjc_ratio[THERM_CJC_SIZE];
+extern const int32_t therm_smoothing_filter[THERM_SMOOTHING_STAGES * 5];
+extern const int32_t therm_mains_taps[THERM_MAINS_SAMPLES_PER_CYCLE];
+extern const float cycle_goertzel_coeffs[CYCLE_BINS];
+extern const float cycle_hann_window[CYCLE_BLOCK];
@@ -7,20 +7,87 @@
 #pragma once
 
 #include <stdbool.h>
+#include <stdint.h>
+
+#include "common.h"
+#include "stats.h"
+#include "tables.h"
+
+//! Most extra bits of resolution we'll oversample for. 4^4 = 256 scans per sample.
+#define THERM_MAX_OVERSAMPLE_BITS  (4)
+/*! Mains frequency continuous readings reject by default, in Hz (50 or 60, or
+ *   0 for no mains rejection). Can be changed with `therm_setMains`.
+ */
+#ifndef THERM_MAINS_HZ
+#define THERM_MAINS_HZ  (60)
+#endif
+
+//! Time the analog front end needs after being powered up before it reads right
+#define THERM_SETTLE_TIME_MS  (1)
+
+//! Fractional bits of the calibration gain. 1 << this is no correction.
+#define THERM_CAL_GAIN_SHIFT  (24)
+
+
+/*! One point of a two-point calibration, both sides as q16 vout / vref ratios
+ *   with the cold junction taken off: what the ADC saw (before any
+ *   calibration), and what it should have seen for the reference temperature.
+ */
+typedef struct {
+    int32_t raw;
+    int32_t target;
+} therm_cal_point_t;
 
 void therm_init(void);
+ret_t therm_setWindow(uint16_t num_readings);
+ret_t therm_configureContinuous(uint32_t rate_hz, uint16_t size);
+ret_t therm_setOversampling(uint8_t extra_bits);
+ret_t therm_setMains(uint8_t hz);
+ret_t therm_setDespike(uint16_t window, uint16_t threshold_tenths);
+ret_t therm_setFilter(const int32_t * coeffs, uint8_t num_stages, uint8_t post_shift);
+ret_t therm_configureAdaptive(uint32_t target_se, uint16_t min_conversions, uint16_t max_conversions);
+ret_t therm_setCalibration(int32_t gain, int32_t offset);
 void therm_startReading_single(void);
 void therm_startReading_continuous(void);
-void therm_ADC_done(void);
+void therm_startReading_adaptive(void);
+void therm_stopReading(void);
+void therm_powerUp(void);
+ret_t therm_powerDown(void);
+uint32_t therm_process(void);
+void therm_setWakeThreshold(int32_t threshold);
+bool therm_aboveThreshold_watchdog(void);
+int32_t therm_getValue_averaged_cC(void);
+int32_t therm_getValue_single_cC(void);
 float therm_getValue_averaged(void);
 float therm_getValue_single(void);
+const stats_t * therm_getStats(void);
+
+// Trend tracking
+void therm_resetTracker(void);
+bool therm_trackerValid(void);
+int32_t therm_getEstimate_cC(void);
+int32_t therm_getSlope_cC(void);
+uint32_t therm_getUncertainty_cC(void);
+uint32_t therm_timeUntilUncertain_ms(uint32_t max_uncertainty, uint32_t limit_ms);
+int32_t therm_getColdJunction_cC(void);
+
+// Calibration
+void therm_captureCalPoint(int32_t reference, int32_t measured, therm_cal_point_t * point);
+ret_t therm_solveCalibration(const therm_cal_point_t * low, const therm_cal_point_t * high,
+                             int32_t * gain, int32_t * offset);
 
 // Utilities
 inline float c2f(float celsius_data);
+static inline int32_t c2f_centi(int32_t centi_celsius);
 
 // Status functions
 bool therm_ADCRunning(void);
+bool therm_settled(void);
 bool therm_valueReady(void);
+uint32_t therm_missedSamples(void);
+uint32_t therm_rejectedSamples(void);
+uint16_t therm_lastConversionCount(void);
+uint32_t therm_totalConversionCount(void);
 
 
 /*! Converts celsius to farenheight.
@@ -29,3 +96,11 @@ inline float c2f(float celsius_data)
 {
     return celsius_data * (9.0 / 5.0) + 32.0;
 }
+
+/*! Converts centi-degrees celsius to centi-degrees farenheight. 9/5 is done
+ *   as 58982 / 2^15 (off by 0.4 centi-degrees at 300 C), so no divide.
+ */
+static inline int32_t c2f_centi(int32_t centi_celsius)
+{
+    return (int32_t)(((int64_t)centi_celsius * 58982) >> 15) + 3200;
+}
@@ -0,0 +1,40 @@
+/*!
+ * @file    tracker.h
+ * @author  Tyler Holmes
+ * @date    16-Oct-2026
+ * @brief   Kalman filter tracking temperature and its rate of rise.
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "common.h"
+
+
+/*! Two state (temperature, slope) Kalman filter. The slope is modeled as a
+ *   random walk, so between measurements the temperature is extrapolated
+ *   along it and the uncertainty grows with how fast the slope can change.
+ *   Temperatures are in centi-degrees, time in HAL ticks (ms).
+ */
+typedef struct {
+    float temp;         //!< estimated temperature at `last_tick`, centi-degrees
+    float slope;        //!< estimated rate of rise, centi-degrees per second
+    float p00;          //!< variance of `temp`
+    float p01;          //!< covariance of `temp` and `slope`
+    float p11;          //!< variance of `slope`
+    float process_var;  //!< how fast the slope wanders, (cdeg / s)^2 per second
+    uint32_t last_tick; //!< tick of the last measurement
+    bool initialized;   //!< false until the first measurement
+} tracker_t;
+
+
+void tracker_init(tracker_t * tracker, float process_var);
+void tracker_reset(tracker_t * tracker);
+void tracker_update(tracker_t * tracker, int32_t measurement, float measurement_var, uint32_t tick);
+
+bool tracker_valid(const tracker_t * tracker);
+int32_t tracker_estimate(const tracker_t * tracker, uint32_t tick);
+int32_t tracker_slope(const tracker_t * tracker);
+uint32_t tracker_uncertainty(const tracker_t * tracker, uint32_t tick);
+uint32_t tracker_timeUntil(const tracker_t * tracker, uint32_t max_uncertainty, uint32_t limit_ms);
@@ -0,0 +1,102 @@
+/*!
+ * @file    calibration.c
+ * @author  Tyler Holmes
+ * @date    16-Oct-2026
+ * @brief   Per-unit calibration record, kept in its own flash sector.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "calibration.h"
+#include "common.h"
+#include "stm32f4xx_hal.h"
+#include "stm32f4xx_hal_flash.h"
+#include "stm32f4xx_hal_flash_ex.h"
+
+//! Reflected CRC-32 polynomial (same CRC as zlib)
+#define CAL_CRC32_POLY  (0xEDB88320UL)
+//! Bytes of the record the CRC covers
+#define CAL_CRC_LENGTH  (offsetof(cal_record_t, crc))
+
+
+/*! Copies the record out of flash into `record` and checks it. Returns
+ *   RET_CAL_ERR if there isn't one (blank sector, or an older layout) and
+ *   RET_BAD_CHECKSUM if it's been corrupted. `record` is filled in either way.
+ */
+ret_t cal_load(cal_record_t * record)
+{
+    *record = *(const cal_record_t *)CAL_FLASH_ADDR;
+
+    if (record->magic != CAL_MAGIC || record->version != CAL_VERSION) {
+        return RET_CAL_ERR;
+    }
+    if (record->crc != cal_crc32(record, CAL_CRC_LENGTH)) {
+        return RET_BAD_CHECKSUM;
+    }
+    return RET_OK;
+}
+
+/*! Writes `gain` and `offset` of `record` to flash, filling in the rest. Erases
+ *   the whole sector first, which stalls the CPU for a second or two, so only
+ *   call it while calibrating.
+ */
+ret_t cal_store(cal_record_t * record)
+{
+    FLASH_EraseInitTypeDef erase;
+    const uint32_t * words = (const uint32_t *)record;
+    uint32_t sector_error;
+    ret_t retval = RET_OK;
+
+    record->magic = CAL_MAGIC;
+    record->version = CAL_VERSION;
+    record->reserved = 0;
+    record->crc = cal_crc32(record, CAL_CRC_LENGTH);
+
+    if (HAL_FLASH_Unlock() != HAL_OK) {
+        return RET_BUSY_ERR;
+    }
+    __HAL_FLASH_CLEAR_FLAG(FLASH_FLAG_EOP | FLASH_FLAG_OPERR | FLASH_FLAG_WRPERR |
+                           FLASH_FLAG_PGAERR | FLASH_FLAG_PGPERR | FLASH_FLAG_PGSERR);
+
+    erase.TypeErase = FLASH_TYPEERASE_SECTORS;
+    erase.Sector = CAL_FLASH_SECTOR;
+    erase.NbSectors = 1;
+    erase.VoltageRange = FLASH_VOLTAGE_RANGE_3;
+    if (HAL_FLASHEx_Erase(&erase, &sector_error) != HAL_OK) {
+        retval = RET_COM_ERR;
+    }
+
+    for (uint32_t i = 0; retval == RET_OK && i < sizeof(cal_record_t) / sizeof(uint32_t); i++) {
+        if (HAL_FLASH_Program(FLASH_TYPEPROGRAM_WORD, CAL_FLASH_ADDR + i * sizeof(uint32_t),
+                              words[i]) != HAL_OK) {
+            retval = RET_COM_ERR;
+        }
+    }
+    HAL_FLASH_Lock();
+
+    // Read it back the way boot will
+    if (retval == RET_OK) {
+        cal_record_t check;
+
+        retval = cal_load(&check);
+    }
+    return retval;
+}
+
+/*! CRC-32 of `length` bytes at `data`. Bitwise, since it's only run at boot
+ *   and while calibrating, and the CRC peripheral's isn't the same CRC.
+ */
+uint32_t cal_crc32(const void * data, uint32_t length)
+{
+    const uint8_t * bytes = (const uint8_t *)data;
+    uint32_t crc = 0xFFFFFFFFUL;
+
+    for (uint32_t i = 0; i < length; i++) {
+        crc ^= bytes[i];
+        for (uint8_t bit = 0; bit < 8; bit++) {
+            crc = (crc >> 1) ^ (CAL_CRC32_POLY & -(crc & 1));
+        }
+    }
+    return ~crc;
+}
@@ -0,0 +1,251 @@
+/*!
+ * @file    cycle.c
+ * @author  Tyler Holmes
+ * @date    16-Oct-2026
+ * @brief   Spots the oven thermostat cycling the element on and off.
+ */
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "common.h"
+#include "cycle.h"
+#include "tables.h"
+
+//! Share of the power across the bins the peak (and the bins either side, which
+//!   the window spreads it into) needs for it to count as a cycle, in percent
+#define CYCLE_MIN_DOMINANCE  (60)
+//! Smallest swing worth calling a cycle, centi-degrees
+#define CYCLE_MIN_AMPLITUDE  (100)
+//! Most the mean can move between blocks and still be holding temperature, centi-degrees
+#define CYCLE_MAX_DRIFT      (200)
+//! Most two blocks' periods can differ by and still agree, in percent
+#define CYCLE_MAX_PERIOD_CHANGE  (25)
+
+#define CYCLE_PI  (3.14159265f)
+
+
+// Private function definitions
+static void cycle_bankReset(cycle_bank_t * bank, int16_t n);
+static void cycle_bankPush(cycle_bank_t * bank, int32_t sample);
+static void cycle_bankDone(cycle_t * cycle, cycle_bank_t * bank);
+
+
+/*! Sets up `cycle` for readings pushed every `sample_ms` ms.
+ */
+ret_t cycle_init(cycle_t * cycle, uint32_t sample_ms)
+{
+    if (sample_ms == 0) {
+        return RET_INVALID_ARGS_ERR;
+    }
+    cycle->sample_ms = sample_ms;
+    cycle_reset(cycle);
+    return RET_OK;
+}
+
+/*! Forgets everything, say when the oven's just been turned on.
+ */
+void cycle_reset(cycle_t * cycle)
+{
+    for (uint8_t i = 0; i < CYCLE_BANKS; i++) {
+        cycle_bankReset(&cycle->banks[i], -(int16_t)(i * CYCLE_BLOCK / CYCLE_BANKS));
+    }
+    cycle->head = 0;
+    cycle->count = 0;
+    cycle->dec_sum = 0;
+    cycle->dec_count = 0;
+    cycle->period_ms = 0;
+    cycle->amplitude = 0;
+    cycle->block_mean = 0;
+    cycle->have_block = false;
+    cycle->cycling = false;
+    cycle->steady = false;
+}
+
+/*! Adds a reading of `temp` centi-degrees. Must be called every `sample_ms`.
+ */
+void cycle_push(cycle_t * cycle, int32_t temp)
+{
+    int32_t sample;
+
+    cycle->dec_sum += temp;
+    if (++cycle->dec_count < CYCLE_DECIMATION) {
+        return;
+    }
+    sample = cycle->dec_sum / CYCLE_DECIMATION;
+    cycle->dec_sum = 0;
+    cycle->dec_count = 0;
+
+    cycle->history[cycle->head] = sample;
+    cycle->head = (cycle->head + 1) % CYCLE_BLOCK;
+    if (cycle->count < CYCLE_BLOCK) {
+        cycle->count++;
+    }
+
+    for (uint8_t i = 0; i < CYCLE_BANKS; i++) {
+        cycle_bank_t * bank = &cycle->banks[i];
+
+        cycle_bankPush(bank, sample);
+        if (bank->n == CYCLE_BLOCK) {
+            cycle_bankDone(cycle, bank);
+            cycle_bankReset(bank, 0);
+        }
+    }
+}
+
+/*! Returns true once the oven's holding temperature: the last two blocks found
+ *   the same clear cycle, and the mean didn't move between them.
+ */
+bool cycle_steady(const cycle_t * cycle)
+{
+    return cycle->steady;
+}
+
+/*! Returns the period of the cycle, in ms, or 0 if there isn't a clear one.
+ */
+uint32_t cycle_period_ms(const cycle_t * cycle)
+{
+    return cycle->cycling ? cycle->period_ms : 0;
+}
+
+/*! Returns how far the temperature swings either side of the mean, in
+ *   centi-degrees, or 0 if there isn't a clear cycle. This is the peak of the
+ *   fundamental, so for the usual sawtooth-ish swing it reads a bit under half
+ *   the peak to peak.
+ */
+int32_t cycle_amplitude(const cycle_t * cycle)
+{
+    return cycle->cycling ? cycle->amplitude : 0;
+}
+
+/*! Returns the mean temperature, in centi-degrees. While cycling it's taken
+ *   over as many whole periods as we have samples for, so it doesn't move with
+ *   where in the cycle we are; otherwise it's over every sample we have.
+ */
+int32_t cycle_mean(const cycle_t * cycle)
+{
+    uint16_t length = cycle->count;
+    uint16_t index;
+    int64_t sum = 0;
+
+    if (length == 0) {
+        return 0;
+    }
+    if (cycle->cycling) {
+        float period = (float)cycle->period_ms / (cycle->sample_ms * CYCLE_DECIMATION);
+        float periods = floorf(length / period);
+
+        if (periods >= 1) {
+            length = (uint16_t)lroundf(periods * period);
+        }
+    }
+
+    index = (cycle->head + CYCLE_BLOCK - length) % CYCLE_BLOCK;
+    for (uint16_t i = 0; i < length; i++) {
+        sum += cycle->history[index];
+        index = (index + 1) % CYCLE_BLOCK;
+    }
+    return (int32_t)(sum / length);
+}
+
+/*! Private function that starts a bank's block over, `-n` samples from now.
+ */
+static void cycle_bankReset(cycle_bank_t * bank, int16_t n)
+{
+    for (uint16_t i = 0; i < CYCLE_BINS; i++) {
+        bank->s1[i] = 0;
+        bank->s2[i] = 0;
+    }
+    bank->offset = 0;
+    bank->sum = 0;
+    bank->n = n;
+}
+
+/*! Private function that runs one sample through every bin of a bank.
+ */
+static void cycle_bankPush(cycle_bank_t * bank, int32_t sample)
+{
+    float x;
+
+    if (bank->n < 0) {
+        bank->n++;
+        return;
+    }
+    if (bank->n == 0) {
+        bank->offset = sample;
+    }
+    x = (float)(sample - bank->offset) * cycle_hann_window[bank->n];
+    for (uint16_t i = 0; i < CYCLE_BINS; i++) {
+        float s = x + cycle_goertzel_coeffs[i] * bank->s1[i] - bank->s2[i];
+
+        bank->s2[i] = bank->s1[i];
+        bank->s1[i] = s;
+    }
+    bank->sum += sample;
+    bank->n++;
+}
+
+/*! Private function that looks at a finished block: finds the strongest bin,
+ *   interpolates the period and swing from it and its neighbours, and decides
+ *   whether the oven's cycling, and if so whether it's steady.
+ */
+static void cycle_bankDone(cycle_t * cycle, cycle_bank_t * bank)
+{
+    float power[CYCLE_BINS];
+    float total = 0;
+    float delta = 0;
+    float gain;
+    uint16_t peak = 0;
+    int32_t mean = (int32_t)(bank->sum / CYCLE_BLOCK);
+    uint32_t period_ms = 0;
+    int32_t amplitude = 0;
+    bool cycling;
+
+    for (uint16_t i = 0; i < CYCLE_BINS; i++) {
+        power[i] = bank->s1[i] * bank->s1[i] + bank->s2[i] * bank->s2[i] -
+                   cycle_goertzel_coeffs[i] * bank->s1[i] * bank->s2[i];
+        total += power[i];
+        if (power[i] > power[peak]) {
+            peak = i;
+        }
+    }
+
+    // A peak on the edge could be a longer or shorter cycle than we look for
+    cycling = peak > 0 && peak < CYCLE_BINS - 1 &&
+              (power[peak - 1] + power[peak] + power[peak + 1]) * 100 >= total * CYCLE_MIN_DOMINANCE;
+    if (cycling) {
+        // The Hann window's peak is close to a gaussian, so a parabola through
+        //   the log powers finds where it really is between bins
+        float a = logf(power[peak - 1] + 1);
+        float b = logf(power[peak] + 1);
+        float c = logf(power[peak + 1] + 1);
+
+        if (a - 2 * b + c < 0) {
+            delta = 0.5f * (a - c) / (a - 2 * b + c);
+        }
+        // Hann amplitude: 4|X|/N on a bin, less by sinc(d)/(1-d^2) off it
+        gain = delta == 0 ? 1 : sinf(CYCLE_PI * delta) / (CYCLE_PI * delta) / (1 - delta * delta);
+        amplitude = (int32_t)lroundf(4 * sqrtf(power[peak]) / CYCLE_BLOCK / gain);
+        period_ms = (uint32_t)lroundf((float)CYCLE_BLOCK * CYCLE_DECIMATION * cycle->sample_ms /
+                                      (CYCLE_MIN_BIN + peak + delta));
+        cycling = amplitude >= CYCLE_MIN_AMPLITUDE;
+    }
+
+    if (cycling) {
+        uint32_t change = period_ms > cycle->period_ms ? period_ms - cycle->period_ms
+                                                       : cycle->period_ms - period_ms;
+
+        cycle->steady = cycle->cycling && cycle->have_block &&
+                        abs(mean - cycle->block_mean) <= CYCLE_MAX_DRIFT &&
+                        change * 100 <= period_ms * CYCLE_MAX_PERIOD_CHANGE;
+        cycle->period_ms = period_ms;
+        cycle->amplitude = amplitude;
+    } else {
+        cycle->steady = false;
+    }
+    cycle->cycling = cycling;
+    cycle->block_mean = mean;
+    cycle->have_block = true;
+}
@@ -5,154 +5,68 @@
  * @brief   C library adapted from the quad I2C LED Backpack adafruit code. More info at bottom.
  */
 
+#include <stdbool.h>
 #include <stdint.h>
 #include "display.h"
 #include "common.h"
+#include "font.h"
 #include "stm32f4xx_hal.h"
 #include "stm32f4xx_hal_i2c.h"
 
 
-static const uint16_t alphafonttable[] = {
-    0b0000000000000001,
-    0b0000000000000010,
-    0b0000000000000100,
-    0b0000000000001000,
-    0b0000000000010000,
-    0b0000000000100000,
-    0b0000000001000000,
-    0b0000000010000000,
-    0b0000000100000000,
-    0b0000001000000000,
-    0b0000010000000000,
-    0b0000100000000000,
-    0b0001000000000000,
-    0b0010000000000000,
-    0b0100000000000000,
-    0b1000000000000000,
-    0b0000000000000000,
-    0b0000000000000000,
-    0b0000000000000000,
-    0b0000000000000000,
-    0b0000000000000000,
-    0b0000000000000000,
-    0b0000000000000000,
-    0b0000000000000000,
-    0b0001001011001001,
-    0b0001010111000000,
-    0b0001001011111001,
-    0b0000000011100011,
-    0b0000010100110000,
-    0b0001001011001000,
-    0b0011101000000000,
-    0b0001011100000000,
-    0b0000000000000000, //
-    0b0000000000000110, // !
-    0b0000001000100000, // "
-    0b0001001011001110, // #
-    0b0001001011101101, // $
-    0b0000110000100100, // %
-    0b0010001101011101, // &
-    0b0000010000000000, // '
-    0b0010010000000000, // (
-    0b0000100100000000, // )
-    0b0011111111000000, // *
-    0b0001001011000000, // +
-    0b0000100000000000, // ,
-    0b0000000011000000, // -
-    0b0000000000000000, // .
-    0b0000110000000000, // /
-    0b0000110000111111, // 0
-    0b0000000000000110, // 1
-    0b0000000011011011, // 2
-    0b0000000010001111, // 3
-    0b0000000011100110, // 4
-    0b0010000001101001, // 5
-    0b0000000011111101, // 6
-    0b0000000000000111, // 7
-    0b0000000011111111, // 8
-    0b0000000011101111, // 9
-    0b0001001000000000, // :
-    0b0000101000000000, // ;
-    0b0010010000000000, // <
-    0b0000000011001000, // =
-    0b0000100100000000, // >
-    0b0001000010000011, // ?
-    0b0000001010111011, // @
-    0b0000000011110111, // A
-    0b0001001010001111, // B
-    0b0000000000111001, // C
-    0b0001001000001111, // D
-    0b0000000011111001, // E
-    0b0000000001110001, // F
-    0b0000000010111101, // G
-    0b0000000011110110, // H
-    0b0001001000000000, // I
-    0b0000000000011110, // J
-    0b0010010001110000, // K
-    0b0000000000111000, // L
-    0b0000010100110110, // M
-    0b0010000100110110, // N
-    0b0000000000111111, // O
-    0b0000000011110011, // P
-    0b0010000000111111, // Q
-    0b0010000011110011, // R
-    0b0000000011101101, // S
-    0b0001001000000001, // T
-    0b0000000000111110, // U
-    0b0000110000110000, // V
-    0b0010100000110110, // W
-    0b0010110100000000, // X
-    0b0001010100000000, // Y
-    0b0000110000001001, // Z
-    0b0000000000111001, // [
-    0b0010000100000000, //
-    0b0000000000001111, // ]
-    0b0000110000000011, // ^
-    0b0000000000001000, // _
-    0b0000000100000000, // `
-    0b0001000001011000, // a
-    0b0010000001111000, // b
-    0b0000000011011000, // c
-    0b0000100010001110, // d
-    0b0000100001011000, // e
-    0b0000000001110001, // f
-    0b0000010010001110, // g
-    0b0001000001110000, // h
-    0b0001000000000000, // i
-    0b0000000000001110, // j
-    0b0011011000000000, // k
-    0b0000000000110000, // l
-    0b0001000011010100, // m
-    0b0001000001010000, // n
-    0b0000000011011100, // o
-    0b0000000101110000, // p
-    0b0000010010000110, // q
-    0b0000000001010000, // r
-    0b0010000010001000, // s
-    0b0000000001111000, // t
-    0b0000000000011100, // u
-    0b0010000000000100, // v
-    0b0010100000010100, // w
-    0b0010100011000000, // x
-    0b0010000000001100, // y
-    0b0000100001001000, // z
-    0b0000100101001001, // {
-    0b0001001000000000, // |
-    0b0010010010001001, // }
-    0b0000010100100000, // ~
-    0b0011111111111111
-};
-
-static const uint16_t alpha_point_mask = (1<<14);
+//! One I2C transfer to the HT16K33, waiting in the queue or going out.
+typedef struct {
+    uint8_t data[DISP_FRAME_BYTES];
+    uint8_t length;
+    bool is_frame;  //!< display words, which a newer frame can take over
+} disp_xfer_t;
+
 
 static uint8_t i2c_addr;
-static uint16_t displaybuffer[8];
+static uint16_t displaybuffer[DISP_WORDS];
+//! What the display will show once the queue's sent, to find what changed
+static uint16_t sentbuffer[DISP_WORDS];
+//! Set when a frame may not have made it, so the next one sends every word
+static volatile bool resend_all;
+
+/*! Transfers waiting to go out over I2C3, oldest first. The main loop adds to
+ *   the head and the I2C interrupt takes from the tail once each is sent. The
+ *   one at the tail is being sent while `xfer_busy`. Both sides touch
+ *   `xfer_busy`, so the main loop masks the I2C interrupts while it queues.
+ */
+static disp_xfer_t xfer_queue[DISP_QUEUE_LEN];
+static volatile uint32_t xfer_head;  //!< free running count of transfers queued. Main loop only
+static volatile uint32_t xfer_tail;  //!< free running count of transfers done. ISR, or with it masked
+static volatile bool xfer_busy;      //!< a transfer is on the bus
+static uint32_t xfer_dropped;        //!< transfers thrown away because the queue was full
+static volatile uint32_t xfer_errors;  //!< transfers the bus or the display failed
+static uint32_t frames_submitted;    //!< `disp_writeDisplay` calls
+static volatile uint32_t frames_sent;  //!< frames that made it onto the display
 
 extern I2C_HandleTypeDef hI2C3;
 
+// Private function definitions
+static void disp_lockQueue(void);
+static void disp_unlockQueue(void);
+static disp_xfer_t * disp_pendingFrame(void);
+static void disp_queue(const uint8_t * data, uint8_t length, bool is_frame);
+static void disp_startNext(void);
+
+/*! Sets up the display at I2C address `addr`. The oscillator is turned on
+ *   with a blocking transfer, so a display that isn't there stops us here;
+ *   everything after that is queued and sent from the I2C interrupts.
+ */
 void disp_init(uint8_t addr)
 {
     i2c_addr = addr;
+    xfer_head = 0;
+    xfer_tail = 0;
+    xfer_busy = false;
+    xfer_dropped = 0;
+    xfer_errors = 0;
+    frames_submitted = 0;
+    frames_sent = 0;
+    resend_all = true;  // no idea what's in its RAM
 
     // turn on oscillator
     uint8_t data = 0x21;
@@ -171,10 +85,9 @@ void disp_setBrightness(uint8_t b)
         b = 15;
     }
     uint8_t data = HT16K33_CMD_BRIGHTNESS | b;
-    HAL_StatusTypeDef retval = HAL_I2C_Master_Transmit(&hI2C3, (uint16_t)i2c_addr, &data, 1, 5);
-    if (retval != HAL_OK) {
-        Error_Handler();
-    }
+    disp_lockQueue();
+    disp_queue(&data, 1, false);
+    disp_unlockQueue();
 }
 
 void disp_blinkRate(uint8_t b)
@@ -184,15 +97,14 @@ void disp_blinkRate(uint8_t b)
     }
 
     uint8_t data = HT16K33_BLINK_CMD | HT16K33_BLINK_DISPLAYON | (b << 1);
-    HAL_StatusTypeDef retval = HAL_I2C_Master_Transmit(&hI2C3, (uint16_t)i2c_addr, &data, 1, 5);
-    if (retval != HAL_OK) {
-        Error_Handler();
-    }
+    disp_lockQueue();
+    disp_queue(&data, 1, false);
+    disp_unlockQueue();
 }
 
 void disp_clear(void)
 {
-    for (uint8_t i = 0; i < 8; i++) {
+    for (uint8_t i = 0; i < DISP_WORDS; i++) {
         displaybuffer[i] = 0;
     }
 }
@@ -206,7 +118,7 @@ void disp_writeDigit_value(uint8_t n, uint8_t number, bool point)
 {
     displaybuffer[n] = alphafonttable[number + 0x30];
     if (point) {
-        displaybuffer[n] |= alpha_point_mask;
+        displaybuffer[n] |= FONT_POINT_MASK;
     }
 }
 
@@ -214,22 +126,231 @@ void disp_writeDigit_ascii(uint8_t n, uint8_t character, bool point)
 {
     displaybuffer[n] = alphafonttable[character];
     if (point) {
-        displaybuffer[n] |= alpha_point_mask;
+        displaybuffer[n] |= FONT_POINT_MASK;
     }
 }
 
+/*! Puts a frame from the renderer on the first `RENDER_DIGITS` digits. Its
+ *   words are ready to go, decimal point and all.
+ */
+void disp_writeFrame(const render_frame_t * frame)
+{
+    for (uint8_t i = 0; i < RENDER_DIGITS; i++) {
+        displaybuffer[i] = frame->glyphs[i];
+    }
+}
+
+/*! Queues up what's been written to the digits to be sent, and returns
+ *   straight away. Only the words that changed since the last frame go, as
+ *   one run from the first to the last of them: the HT16K33 takes a start
+ *   address and auto-increments from there. Usually that's a digit or two,
+ *   5 bytes instead of 17. If nothing changed, nothing's sent. The I2C
+ *   interrupts send it, so the caller can go to sleep. If a frame's still
+ *   waiting its turn, this one takes it over, covering both their words.
+ */
 void disp_writeDisplay(void)
 {
-    // Build up the payload. Start with 0
-    uint8_t data[17];
-    data[0] = 0;
-    for (uint8_t i = 0; i < 8; i++) {
-        data[2*i + 1] = displaybuffer[i] & 0xFF;
-        data[2*i + 2] = displaybuffer[i] >> 8;
+    uint8_t data[DISP_FRAME_BYTES];
+    uint8_t first = DISP_WORDS;
+    uint8_t last = 0;
+    disp_xfer_t * pending;
+
+    frames_submitted++;
+    disp_lockQueue();
+    for (uint8_t i = 0; i < DISP_WORDS; i++) {
+        if (resend_all || displaybuffer[i] != sentbuffer[i]) {
+            if (first == DISP_WORDS) {
+                first = i;
+            }
+            last = i;
+        }
+        sentbuffer[i] = displaybuffer[i];
     }
-    HAL_StatusTypeDef retval = HAL_I2C_Master_Transmit(&hI2C3, (uint16_t)i2c_addr, data, 17, 5);
-    if (retval != HAL_OK) {
-        Error_Handler();
+    resend_all = false;
+
+    if (first != DISP_WORDS) {
+        pending = disp_pendingFrame();
+        if (pending != NULL) {
+            uint8_t pending_first = pending->data[0] / 2;
+            uint8_t pending_last = pending_first + (pending->length - 1) / 2 - 1;
+
+            first = pending_first < first ? pending_first : first;
+            last = pending_last > last ? pending_last : last;
+        }
+
+        // Display RAM address (2 bytes a word), then the words, low byte first
+        data[0] = 2 * first;
+        for (uint8_t i = first; i <= last; i++) {
+            data[2*(i - first) + 1] = displaybuffer[i] & 0xFF;
+            data[2*(i - first) + 2] = displaybuffer[i] >> 8;
+        }
+        disp_queue(data, (uint8_t)(1 + 2*(last - first + 1)), true);
+    }
+    disp_unlockQueue();
+}
+
+/*! Returns true while there's anything still to send to the display.
+ */
+bool disp_busy(void)
+{
+    return xfer_busy;
+}
+
+/*! Sleeps until everything queued has been sent, like before going into STOP
+ *   (which would stop I2C3 mid transfer). Returns RET_BUSY_ERR if it takes
+ *   longer than `timeout_ms`.
+ */
+ret_t disp_flush(uint32_t timeout_ms)
+{
+    uint32_t start = HAL_GetTick();
+
+    while (xfer_busy) {
+        if (HAL_GetTick() - start > timeout_ms) {
+            return RET_BUSY_ERR;
+        }
+        // The I2C interrupts (or the tick) wake us back up
+        HAL_PWR_EnterSLEEPMode(PWR_MAINREGULATOR_ON, PWR_SLEEPENTRY_WFI);
+    }
+    return RET_OK;
+}
+
+/*! Returns how many transfers have been thrown away because the queue was full.
+ */
+uint32_t disp_droppedCount(void)
+{
+    return xfer_dropped;
+}
+
+/*! Returns how many frames `disp_writeDisplay` has been given.
+ */
+uint32_t disp_framesSubmitted(void)
+{
+    return frames_submitted;
+}
+
+/*! Returns how many frames actually went out over I2C. Frames that didn't
+ *   change anything aren't sent, and ones that got taken over by a newer
+ *   frame while queued go out with it, so this is usually a lot less than
+ *   `disp_framesSubmitted`.
+ */
+uint32_t disp_framesSent(void)
+{
+    return frames_sent;
+}
+
+/*! Returns how many transfers failed on the bus. They aren't retried; the
+ *   next frame sends every word to put the display right.
+ */
+uint32_t disp_errorCount(void)
+{
+    return xfer_errors;
+}
+
+/*! Private function that masks the I2C interrupts, so the queue can be
+ *   changed without the ISR moving on underneath us.
+ */
+static void disp_lockQueue(void)
+{
+    HAL_NVIC_DisableIRQ(I2C3_EV_IRQn);
+    HAL_NVIC_DisableIRQ(I2C3_ER_IRQn);
+}
+
+/*! Private function that unmasks the I2C interrupts again.
+ */
+static void disp_unlockQueue(void)
+{
+    HAL_NVIC_EnableIRQ(I2C3_EV_IRQn);
+    HAL_NVIC_EnableIRQ(I2C3_ER_IRQn);
+}
+
+/*! Private function that returns the newest queued transfer if it's a frame
+ *   that hasn't started going out, or NULL. Queue must be locked.
+ */
+static disp_xfer_t * disp_pendingFrame(void)
+{
+    disp_xfer_t * xfer;
+
+    if (xfer_head - xfer_tail <= 1) {
+        return NULL;  // empty, or just the one on the bus
+    }
+    xfer = &xfer_queue[(xfer_head - 1) & (DISP_QUEUE_LEN - 1)];
+    return xfer->is_frame ? xfer : NULL;
+}
+
+/*! Private function that adds a transfer to the queue, and starts it if the
+ *   bus is free. A frame replaces the newest queued one if that's a frame too
+ *   and hasn't started going out, so it has to cover its words as well. If
+ *   the queue's full it's dropped. Queue must be locked.
+ */
+static void disp_queue(const uint8_t * data, uint8_t length, bool is_frame)
+{
+    disp_xfer_t * xfer = is_frame ? disp_pendingFrame() : NULL;
+
+    if (xfer == NULL && xfer_head - xfer_tail < DISP_QUEUE_LEN) {
+        xfer = &xfer_queue[xfer_head & (DISP_QUEUE_LEN - 1)];
+        xfer_head++;
+    }
+
+    if (xfer == NULL) {
+        xfer_dropped++;
+        if (is_frame) {
+            resend_all = true;  // `sentbuffer` has words that never went
+        }
+    } else {
+        for (uint8_t i = 0; i < length; i++) {
+            xfer->data[i] = data[i];
+        }
+        xfer->length = length;
+        xfer->is_frame = is_frame;
+        if (!xfer_busy) {
+            disp_startNext();
+        }
+    }
+}
+
+/*! Private function that starts sending the transfer at the tail, if there is
+ *   one. Called with the I2C interrupts masked, or from them.
+ */
+static void disp_startNext(void)
+{
+    while (xfer_tail != xfer_head) {
+        disp_xfer_t * xfer = &xfer_queue[xfer_tail & (DISP_QUEUE_LEN - 1)];
+
+        if (HAL_I2C_Master_Transmit_IT(&hI2C3, (uint16_t)i2c_addr, xfer->data,
+                                       xfer->length) == HAL_OK) {
+            xfer_busy = true;
+            return;
+        }
+        xfer_errors++;
+        resend_all = true;
+        xfer_tail++;
+    }
+    xfer_busy = false;
+}
+
+/*! HAL callback for a finished I2C transmit. Moves on to the next transfer.
+ */
+void HAL_I2C_MasterTxCpltCallback(I2C_HandleTypeDef * hi2c)
+{
+    if (hi2c->Instance == I2C3) {
+        if (xfer_queue[xfer_tail & (DISP_QUEUE_LEN - 1)].is_frame) {
+            frames_sent++;
+        }
+        xfer_tail++;
+        disp_startNext();
+    }
+}
+
+/*! HAL callback for an I2C error, like the display not acking. The transfer's
+ *   given up on and we move on to the next.
+ */
+void HAL_I2C_ErrorCallback(I2C_HandleTypeDef * hi2c)
+{
+    if (hi2c->Instance == I2C3) {
+        xfer_errors++;
+        resend_all = true;
+        xfer_tail++;
+        disp_startNext();
     }
 }
 
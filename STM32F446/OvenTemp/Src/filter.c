@@ -0,0 +1,153 @@
+/*!
+ * @file    filter.c
+ * @author  Tyler Holmes
+ * @date    16-Oct-2026
+ * @brief   Block IIR filter stage built on the CMSIS-DSP q31 biquad cascade.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "common.h"
+#include "filter.h"
+
+
+/*! Sets up `filter` to run `num_stages` biquads with the given coefficients,
+ *   `FILTER_COEFFS_PER_STAGE` per stage. Coefficients are q31, scaled down by
+ *   2^`post_shift` so ones outside of [-1, 1) fit (a1 of a low pass usually
+ *   doesn't). `num_stages` of 0 turns the filter off. The coefficients are
+ *   copied, so they don't need to stick around.
+ */
+ret_t filter_init(filter_t * filter, const q31_t * coeffs, uint8_t num_stages, uint8_t post_shift)
+{
+    if (num_stages > FILTER_MAX_STAGES || post_shift > 31 ||
+        (num_stages != 0 && coeffs == NULL)) {
+        return RET_INVALID_ARGS_ERR;
+    }
+    for (uint16_t i = 0; i < num_stages * FILTER_COEFFS_PER_STAGE; i++) {
+        filter->coeffs[i] = coeffs[i];
+    }
+    filter->num_stages = num_stages;
+    if (num_stages != 0) {
+        arm_biquad_cascade_df1_init_q31(&filter->inst, num_stages, filter->coeffs,
+                                        filter->state, (int8_t)post_shift);
+    }
+    filter_reset(filter);
+    return RET_OK;
+}
+
+/*! Forgets everything the filter has seen. The next sample primes it.
+ */
+void filter_reset(filter_t * filter)
+{
+    filter->primed = false;
+}
+
+/*! Filters `num_samples` samples in place. A block at a time lets the biquads
+ *   stay in registers and use the M4's 64 bit MACs, instead of calling into
+ *   the filter per sample.
+ *
+ *   The first sample after a reset fills the state as if the filter had been
+ *   sitting at that value forever, so there's no step in from zero. That only
+ *   holds for stages with unity DC gain, like the low passes we use.
+ */
+void filter_process(filter_t * filter, int32_t * samples, uint32_t num_samples)
+{
+    if (filter->num_stages == 0 || num_samples == 0) {
+        return;
+    }
+
+    for (uint32_t i = 0; i < num_samples; i++) {
+        samples[i] = (int32_t)((uint32_t)samples[i] << FILTER_FRAC_BITS);
+    }
+
+    if (!filter->primed) {
+        for (uint16_t i = 0; i < filter->num_stages * 4; i++) {
+            filter->state[i] = samples[0];
+        }
+        filter->primed = true;
+    }
+
+    // Safe to run in place, each input is read before its output is written
+    arm_biquad_cascade_df1_q31(&filter->inst, samples, samples, num_samples);
+
+    for (uint32_t i = 0; i < num_samples; i++) {
+        samples[i] >>= FILTER_FRAC_BITS;
+    }
+}
+
+/*! Returns true if the filter has any stages to run.
+ */
+bool filter_enabled(const filter_t * filter)
+{
+    return filter->num_stages != 0;
+}
+
+/*! Sets up `decim` to average every `factor` samples down to one, with
+ *   `arm_fir_decimate_q31` and `factor` boxcar `taps` (1 / `factor` each, in
+ *   q31). A `factor` of 0 passes samples straight through.
+ */
+ret_t filter_decimInit(filter_decim_t * decim, const q31_t * taps, uint8_t factor)
+{
+    if (factor > FILTER_DECIM_MAX_FACTOR || (factor != 0 && taps == NULL)) {
+        return RET_INVALID_ARGS_ERR;
+    }
+    decim->factor = factor;
+    if (factor != 0) {
+        // CMSIS only reads the taps, they can stay in flash
+        if (arm_fir_decimate_init_q31(&decim->inst, factor, factor, (q31_t *)taps,
+                                      decim->state, factor) != ARM_MATH_SUCCESS) {
+            return RET_VAL_ERR;
+        }
+    }
+    filter_decimReset(decim);
+    return RET_OK;
+}
+
+/*! Throws away any samples waiting to be decimated and the FIR history. The
+ *   next sample primes it.
+ */
+void filter_decimReset(filter_decim_t * decim)
+{
+    decim->num_pending = 0;
+    decim->primed = false;
+}
+
+/*! Decimates `num_samples` samples in place. Returns how many came out, which
+ *   are at the start of `samples`. Leftovers that don't make a full block are
+ *   kept for the next call.
+ *
+ *   Each output's window is the last `factor` - 1 samples of the previous block
+ *   plus the first of its own, so like `filter_process` the first sample after
+ *   a reset fills that history. Otherwise the first outputs after a reset are
+ *   mostly zeros and come out far too low.
+ */
+uint32_t filter_decimProcess(filter_decim_t * decim, int32_t * samples, uint32_t num_samples)
+{
+    uint32_t num_out = 0;
+
+    if (decim->factor == 0) {
+        return num_samples;
+    }
+
+    if (!decim->primed && num_samples != 0) {
+        // CMSIS keeps the history at the front of its state
+        for (uint8_t i = 0; i < decim->factor - 1; i++) {
+            decim->state[i] = (q31_t)((uint32_t)samples[0] << FILTER_FRAC_BITS);
+        }
+        decim->primed = true;
+    }
+
+    for (uint32_t i = 0; i < num_samples; i++) {
+        decim->pending[decim->num_pending++] = (q31_t)((uint32_t)samples[i] << FILTER_FRAC_BITS);
+        if (decim->num_pending == decim->factor) {
+            q31_t out;
+
+            // One output per block, so it never catches up to the input we're reading
+            arm_fir_decimate_q31(&decim->inst, decim->pending, &out, decim->factor);
+            samples[num_out++] = out >> FILTER_FRAC_BITS;
+            decim->num_pending = 0;
+        }
+    }
+    return num_out;
+}
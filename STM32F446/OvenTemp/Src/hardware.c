@@ -14,13 +14,19 @@
 #include "stm32f4xx_hal_rtc_ex.h"
 
 extern ADC_HandleTypeDef hadc1;
+#if ADC_SIMULTANEOUS
+extern ADC_HandleTypeDef hadc2;
+#endif
 extern DMA_HandleTypeDef hdma_adc1;
 extern I2C_HandleTypeDef hI2C3;
 extern RTC_HandleTypeDef hrtc;
+extern TIM_HandleTypeDef htim2;
 extern UART_HandleTypeDef huart4;
 
 #define WDG_COUNT  (410u)  // TODO: recalculate
 
+static adc_trigger_t adc1_trigger = kADCTrigger_Software;  //!< current ADC1 trigger source
+
 // Private functions
 
 /** System Clock Configuration
@@ -102,16 +108,25 @@ void hw_ADC1_Init(void)
     hadc1.Instance = ADC1;
     hadc1.Init.ClockPrescaler = ADC_CLOCK_SYNC_PCLK_DIV2;
     hadc1.Init.Resolution = ADC_RESOLUTION_12B;
+#if ADC_SIMULTANEOUS
+    // just vout (and the die temperature), ADC2 takes vref
+    hadc1.Init.ScanConvMode = ADC_SCAN_DIE_TEMP ? ENABLE : DISABLE;
+#else
     hadc1.Init.ScanConvMode = ENABLE;
+#endif
     hadc1.Init.ContinuousConvMode = DISABLE;
-    hadc1.Init.DiscontinuousConvMode = ENABLE;
+    hadc1.Init.DiscontinuousConvMode = DISABLE;  // whole sequence per trigger
     hadc1.Init.ExternalTrigConvEdge = ADC_EXTERNALTRIGCONVEDGE_NONE;
     hadc1.Init.ExternalTrigConv = ADC_SOFTWARE_START;
     hadc1.Init.DataAlign = ADC_DATAALIGN_RIGHT;
-    hadc1.Init.NbrOfDiscConversion = 1;
+    hadc1.Init.NbrOfDiscConversion = 0;
+#if ADC_SIMULTANEOUS
+    hadc1.Init.NbrOfConversion = NUM_ADC_CHANNELS / 2;
+#else
     hadc1.Init.NbrOfConversion = NUM_ADC_CHANNELS;
-    hadc1.Init.DMAContinuousRequests = DISABLE;
-    hadc1.Init.EOCSelection = ADC_EOC_SINGLE_CONV;
+#endif
+    hadc1.Init.DMAContinuousRequests = DISABLE;  // one DMA transfer per scan
+    hadc1.Init.EOCSelection = ADC_EOC_SEQ_CONV;
     if (HAL_ADC_Init(&hadc1) != HAL_OK)
     {
       _Error_Handler(__FILE__, __LINE__);
@@ -127,14 +142,256 @@ void hw_ADC1_Init(void)
       _Error_Handler(__FILE__, __LINE__);
     }
 
+#if ADC_SCAN_DIE_TEMP
+    // Die temperature sensor, for cold junction compensation. Turns on its
+    //   path (TSVREFE) too. 112 cycles is 14us, over the 10us it needs.
+    sConfig.Channel = ADC_CHANNEL_TEMPSENSOR;
+    sConfig.Rank = 2;
+    if (HAL_ADC_ConfigChannel(&hadc1, &sConfig) != HAL_OK) {
+        Error_Handler();
+    }
+#endif
+
+#if !ADC_SIMULTANEOUS
       /**Configure for the selected ADC regular channel its corresponding rank in the sequencer and its sample time.
       */
     sConfig.Channel = ADC_CHANNEL_6;
-    sConfig.Rank = 2;
+    sConfig.Rank = ADC_SCAN_VREF + 1;
     if (HAL_ADC_ConfigChannel(&hadc1, &sConfig) != HAL_OK)
     {
       _Error_Handler(__FILE__, __LINE__);
     }
+#endif
+}
+
+/*! ADC2 init function. Only used with `ADC_SIMULTANEOUS`, where ADC2 is the
+ *   slave that converts vref at the same time ADC1 converts vout. The pair
+ *   comes out of the common data register as one word, ADC1 in the low half,
+ *   which the DMA (in word mode) lays down in memory as vout, vref (then die
+ *   temperature, vref with `ADC_SCAN_DIE_TEMP`).
+ *   Must come after `hw_ADC1_Init`.
+ */
+void hw_ADC2_Init(void)
+{
+#if ADC_SIMULTANEOUS
+    ADC_ChannelConfTypeDef sConfig;
+    ADC_MultiModeTypeDef sMultiMode;
+
+    hadc2.Instance = ADC2;
+    hadc2.Init = hadc1.Init;  // triggers are ignored, the master starts both
+    hadc2.Init.ExternalTrigConvEdge = ADC_EXTERNALTRIGCONVEDGE_NONE;
+    hadc2.Init.ExternalTrigConv = ADC_SOFTWARE_START;
+    hadc2.Init.DMAContinuousRequests = DISABLE;
+    if (HAL_ADC_Init(&hadc2) != HAL_OK) {
+        Error_Handler();
+    }
+
+    // Has to match ADC1's sample time to stay in lock step
+    sConfig.Channel = ADC_CHANNEL_6;
+    sConfig.Rank = 1;
+    sConfig.SamplingTime = ADC_SAMPLETIME_112CYCLES;
+    if (HAL_ADC_ConfigChannel(&hadc2, &sConfig) != HAL_OK) {
+        Error_Handler();
+    }
+#if ADC_SCAN_DIE_TEMP
+    // vref again while ADC1 converts the die temperature. Also leaves vref in
+    //   the top half of the common data register for `hw_ADC_getVref`.
+    sConfig.Rank = 2;
+    if (HAL_ADC_ConfigChannel(&hadc2, &sConfig) != HAL_OK) {
+        Error_Handler();
+    }
+#endif
+
+    sMultiMode.Mode = ADC_DUALMODE_REGSIMULT;
+    sMultiMode.DMAAccessMode = ADC_DMAACCESSMODE_2;  // both 12 bit results in one word
+    sMultiMode.TwoSamplingDelay = ADC_TWOSAMPLINGDELAY_5CYCLES;  // unused in simultaneous mode
+    if (HAL_ADCEx_MultiModeConfigChannel(&hadc1, &sMultiMode) != HAL_OK) {
+        Error_Handler();
+    }
+#endif
+}
+
+/*! Starts `num_scans` scans of every channel, moved by the DMA into `dest`
+ *   in the order given by the `ADC_SCAN_` indices. Whether it's one scan or
+ *   many depends on the trigger set with `hw_ADC1_setTrigger`. The HAL turns
+ *   on the DMA half transfer interrupt, which only double buffered readings
+ *   want: without `half_transfer` it's turned back off, so a one shot
+ *   transfer only interrupts once, when it's done.
+ */
+HAL_StatusTypeDef hw_ADC_startDMA(uint16_t * dest, uint32_t num_scans, bool half_transfer)
+{
+    HAL_StatusTypeDef ret;
+
+#if ADC_SIMULTANEOUS
+    // The slave has to be on before the master starts converting. One word
+    //   (ADC1 and ADC2 results) per rank.
+    __HAL_ADC_ENABLE(&hadc2);
+    ret = HAL_ADCEx_MultiModeStart_DMA(&hadc1, (uint32_t *)dest,
+                                       num_scans * (NUM_ADC_CHANNELS / 2));
+#else
+    ret = HAL_ADC_Start_DMA(&hadc1, (uint32_t *)dest, num_scans * NUM_ADC_CHANNELS);
+#endif
+    // The first scan takes 15us or more, so this is well before the DMA gets halfway
+    if (ret == HAL_OK && !half_transfer) {
+        __HAL_DMA_DISABLE_IT(hadc1.DMA_Handle, DMA_IT_HT);
+    }
+    return ret;
+}
+
+/*! Stops the ADC(s) and the DMA started with `hw_ADC_startDMA`.
+ */
+void hw_ADC_stopDMA(void)
+{
+#if ADC_SIMULTANEOUS
+    (void)HAL_ADCEx_MultiModeStop_DMA(&hadc1);
+    __HAL_ADC_DISABLE(&hadc2);
+#else
+    (void)HAL_ADC_Stop_DMA(&hadc1);
+#endif
+}
+
+/*! Returns the vref conversion from the last (polled) scan.
+ */
+uint16_t hw_ADC_getVref(void)
+{
+#if ADC_SIMULTANEOUS
+    return (uint16_t)(HAL_ADCEx_MultiModeGetValue(&hadc1) >> 16);
+#else
+    // vref is the last rank, so it's what's left in the data register
+    return (uint16_t)HAL_ADC_GetValue(&hadc1);
+#endif
+}
+
+/*! Switches what starts an ADC1 scan. Software triggered scans stop the DMA
+ *   requests after one sequence, while timer triggered scans keep requesting
+ *   so the circular DMA buffer can be filled block after block.
+ *   Must only be called while the ADC is stopped.
+ */
+void hw_ADC1_setTrigger(adc_trigger_t trigger)
+{
+    if (trigger == adc1_trigger) {
+        return;
+    }
+
+    if (trigger == kADCTrigger_Timer) {
+        hadc1.Init.ExternalTrigConvEdge = ADC_EXTERNALTRIGCONVEDGE_RISING;
+        hadc1.Init.ExternalTrigConv = ADC_EXTERNALTRIGCONV_T2_TRGO;
+        hadc1.Init.DMAContinuousRequests = ENABLE;
+    } else {
+        hadc1.Init.ExternalTrigConvEdge = ADC_EXTERNALTRIGCONVEDGE_NONE;
+        hadc1.Init.ExternalTrigConv = ADC_SOFTWARE_START;
+        hadc1.Init.DMAContinuousRequests = DISABLE;
+    }
+    if (HAL_ADC_Init(&hadc1) != HAL_OK) {
+        Error_Handler();
+    }
+    adc1_trigger = trigger;
+}
+
+/*! Arms (or disarms) the ADC1 analog watchdog on the thermocouple output
+ *   (ADC_CHANNEL_4). Once armed, any regular conversion of vout above
+ *   `high_threshold` raw 12 bit counts sets the AWD flag, no software needed.
+ */
+void hw_ADC1_setWatchdog(bool enable, uint16_t high_threshold)
+{
+    ADC_AnalogWDGConfTypeDef sWatchdog;
+
+    sWatchdog.WatchdogMode = enable ? ADC_ANALOGWATCHDOG_SINGLE_REG : ADC_ANALOGWATCHDOG_NONE;
+    sWatchdog.HighThreshold = high_threshold;
+    sWatchdog.LowThreshold = 0;
+    sWatchdog.Channel = ADC_CHANNEL_4;
+    sWatchdog.ITMode = DISABLE;  // polled right after the scan
+    sWatchdog.WatchdogNumber = 0;
+    if (HAL_ADC_AnalogWDGConfig(&hadc1, &sWatchdog) != HAL_OK) {
+        Error_Handler();
+    }
+    __HAL_ADC_CLEAR_FLAG(&hadc1, ADC_FLAG_AWD);
+}
+
+/*! Powers the ADC(s) up or down. Down gates their clocks, after clearing ADON,
+ *   so they draw nothing between readings; the HAL handles and registers are
+ *   kept. Up turns the clocks back on and sets ADON, so the ~3us stabilisation
+ *   is long over by the time the analog front end has settled and a reading
+ *   starts. The die temperature sensor goes with them; its 10us start up is
+ *   covered the same way.
+ */
+void hw_ADC_setPower(bool on)
+{
+    if (on) {
+        __HAL_RCC_ADC1_CLK_ENABLE();
+        __HAL_ADC_ENABLE(&hadc1);
+#if ADC_SCAN_DIE_TEMP
+        ADC123_COMMON->CCR |= ADC_CCR_TSVREFE;
+#endif
+#if ADC_SIMULTANEOUS
+        __HAL_RCC_ADC2_CLK_ENABLE();
+        __HAL_ADC_ENABLE(&hadc2);
+#endif
+    } else {
+#if ADC_SCAN_DIE_TEMP
+        ADC123_COMMON->CCR &= ~ADC_CCR_TSVREFE;
+#endif
+        __HAL_ADC_DISABLE(&hadc1);
+        __HAL_RCC_ADC1_CLK_DISABLE();
+#if ADC_SIMULTANEOUS
+        __HAL_ADC_DISABLE(&hadc2);
+        __HAL_RCC_ADC2_CLK_DISABLE();
+#endif
+    }
+}
+
+/*! Powers the analog front end (thermocouple amp and reference) up or down.
+ */
+void hw_AFE_setPower(bool on)
+{
+    // Active low
+    HAL_GPIO_WritePin(AFE_EN_PORT, AFE_EN_PIN, on ? GPIO_PIN_RESET : GPIO_PIN_SET);
+}
+
+/*! TIM2 init function. TIM2 is only used as the ADC sample clock: its update
+ *   event is routed to TRGO, which triggers an ADC1 scan.
+ */
+void hw_TIM2_Init(void)
+{
+    TIM_MasterConfigTypeDef sMasterConfig;
+
+    htim2.Instance = TIM2;
+    htim2.Init.Prescaler = (HAL_RCC_GetPCLK1Freq() / TIM2_TICK_HZ) - 1;
+    htim2.Init.CounterMode = TIM_COUNTERMODE_UP;
+    htim2.Init.Period = (TIM2_TICK_HZ / 100) - 1;  // placeholder, set on start
+    htim2.Init.ClockDivision = TIM_CLOCKDIVISION_DIV1;
+    if (HAL_TIM_Base_Init(&htim2) != HAL_OK) {
+        Error_Handler();
+    }
+
+    sMasterConfig.MasterOutputTrigger = TIM_TRGO_UPDATE;
+    sMasterConfig.MasterSlaveMode = TIM_MASTERSLAVEMODE_DISABLE;
+    if (HAL_TIMEx_MasterConfigSynchronization(&htim2, &sMasterConfig) != HAL_OK) {
+        Error_Handler();
+    }
+}
+
+/*! Starts TIM2 generating ADC triggers at `rate_hz`.
+ */
+ret_t hw_TIM2_start(uint32_t rate_hz)
+{
+    if (rate_hz == 0 || rate_hz > TIM2_TICK_HZ) {
+        return RET_INVALID_ARGS_ERR;
+    }
+    __HAL_TIM_SET_COUNTER(&htim2, 0);
+    // Rounded, so rates that don't divide the tick evenly are as close as we can get
+    __HAL_TIM_SET_AUTORELOAD(&htim2, ((TIM2_TICK_HZ + rate_hz / 2) / rate_hz) - 1);
+    if (HAL_TIM_Base_Start(&htim2) != HAL_OK) {
+        return RET_BUSY_ERR;
+    }
+    return RET_OK;
+}
+
+/*! Stops the ADC sample clock.
+ */
+void hw_TIM2_stop(void)
+{
+    HAL_TIM_Base_Stop(&htim2);
 }
 
 /* I2C3 init function */
@@ -252,6 +509,7 @@ void hw_GPIO_Init(void)
 
     /* GPIO Ports Clock Enable */
     __HAL_RCC_GPIOA_CLK_ENABLE();
+    __HAL_RCC_GPIOB_CLK_ENABLE();
     __HAL_RCC_GPIOC_CLK_ENABLE();
 
     // PA5 is LD2 LED, PA7 and PA2 are timing pins
@@ -271,6 +529,14 @@ void hw_GPIO_Init(void)
     GPIO_InitStruct.Pull = GPIO_NOPULL;
     HAL_GPIO_Init(GPIOA, &GPIO_InitStruct);
 
+    // Analog front end enable. Set high (off) first so it doesn't glitch on
+    HAL_GPIO_WritePin(AFE_EN_PORT, AFE_EN_PIN, GPIO_PIN_SET);
+    GPIO_InitStruct.Pin = AFE_EN_PIN;
+    GPIO_InitStruct.Mode = GPIO_MODE_OUTPUT_PP;
+    GPIO_InitStruct.Pull = GPIO_NOPULL;
+    GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_LOW;
+    HAL_GPIO_Init(AFE_EN_PORT, &GPIO_InitStruct);
+
     // PC13/PC14 are RTC input pins
     GPIO_InitStruct.Pin = GPIO_PIN_13 | GPIO_PIN_14;
     GPIO_InitStruct.Mode = GPIO_MODE_AF_OD;
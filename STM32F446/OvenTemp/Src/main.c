@@ -11,9 +11,13 @@
 #include <stdint.h>
 #include <string.h>
 
+#include "calibration.h"
 #include "common.h"
+#include "cycle.h"
 #include "hardware.h"
 #include "display.h"
+#include "preheat.h"
+#include "render.h"
 #include "thermocouple.h"
 #include "stm32f4xx_hal.h"
 
@@ -33,16 +37,87 @@
 //! How long we sleep between readings in active mode, in seconds.
 #define ACTIVE_MODE_SLEEPTIME  (1)
 
-//! threshold to switch to active mode, in celsius
-#define ACTIVE_TEMP_THRESHOLD   (50.0f)
-#define INSANE_TEMP_THRESHOLD   (250.0f)
+//! threshold to switch to active mode, in centi-degrees celsius
+#define ACTIVE_TEMP_THRESHOLD   (5000L)
+#define INSANE_TEMP_THRESHOLD   (25000L)
 
 #define IDLE_SAMPLE_TIME_MS    (60000UL)  // TODO: change to 60 seconds
 #define ACTIVE_SAMPLE_TIME_MS  (1000)
+//! Time to spend in STOP between idle samples. The analog front end settles
+//!   in the rest, so samples are still `IDLE_SAMPLE_TIME_MS` apart.
+#define IDLE_WAKE_TIME_MS  (IDLE_SAMPLE_TIME_MS - THERM_SETTLE_TIME_MS - 1)
+
+//! Extra ADC bits per mode. Idle only needs to spot the oven turning on, active
+//!   trades a 16 scan burst (~1ms of conversions) for 14 bit readings.
+#define IDLE_OVERSAMPLE_BITS    (0)
+#define ACTIVE_OVERSAMPLE_BITS  (2)
+
+/*! Set to 1 to have idle mode check the threshold with the ADC analog watchdog
+ *   instead of a full reading, which drops the one DMA complete interrupt a
+ *   full scan takes and all the temperature math while the oven is off.
+ *
+ *   Wakeups per 60 second idle sample, counted from the code and the HAL's
+ *   interrupt handling (not measured on the board), either way:
+ *    - 1 RTC wakeup out of STOP
+ *    - ~2 SysTicks sleeping through the front end settle (`therm_settled`
+ *      wants the tick to move past `THERM_SETTLE_TIME_MS`)
+ *    - ~14 I2C3 event interrupts: the idle decimal point is cleared before
+ *      STOP and set again after, two 3 byte transfers at ~7 each (start,
+ *      address, 3 bytes, the last TXE, BTF)
+ *    - plus 1 DMA complete without the watchdog
+ *   That's ~17 instead of ~18, so ~24,480 wakeups a day instead of ~25,920.
+ *   The watchdog saves 1,440 of them; the display is most of what's left.
+ */
+#define IDLE_USE_ADC_WATCHDOG   (1)
+
+/*! Set to 1 to have the temperature tracker decide when active mode takes a
+ *   reading. The display still updates every `ACTIVE_SAMPLE_TIME_MS` from the
+ *   tracker's estimate, but a new reading is only taken once that estimate
+ *   could be off by more than `ACTIVE_MAX_UNCERTAINTY` (one standard deviation).
+ *   While the oven holds steady that's every few seconds instead of every one.
+ */
+#define ACTIVE_USE_TRACKER         (1)
+#define ACTIVE_MAX_UNCERTAINTY     (100)    //!< centi-degrees celsius
+#define ACTIVE_MAX_SAMPLE_TIME_MS  (10000)  //!< longest we'll go without a reading
+
+/*! While heating, every other display update shows the time until the oven
+ *   reaches `ETA_TARGET_TEMP` (350 F), once the fit through the last
+ *   `ETA_WINDOW` readings is at least `ETA_MIN_CONFIDENCE` percent sure of it.
+ */
+#define ETA_TARGET_TEMP     (17667L)  //!< centi-degrees celsius
+#define ETA_WINDOW          (16)
+#define ETA_MIN_CONFIDENCE  (50)
+
+/*! Once the oven's holding temperature, the thermostat cycling the element
+ *   makes the reading swing up and down. When the cycle detector is sure of
+ *   that, the display shows the mean across cycles instead, and only updates
+ *   every `STEADY_DISPLAY_TIME_MS`.
+ */
+#define STEADY_DISPLAY_TIME_MS  (10000)
+
+/*! The displayed temperature only moves once a reading is this far from it,
+ *   in centi-degrees of the displayed unit. A tenth of a degree is the last
+ *   digit over 100, so noise under that doesn't repaint it.
+ */
+#define DISPLAY_DEADBAND  (10)
+
+/*! Two-point calibration capture, DEBUG builds only. Send `CAL_REQUEST_CHAR`
+ *   over UART4 while the display says HI, then for each point: hold the probe
+ *   at a known temperature and type it in, in C (e.g. "0" for an ice bath,
+ *   "100.0" for boiling water). `CAL_POINT_READINGS` adaptive readings are
+ *   averaged for each. The result goes into the calibration sector.
+ */
+#define CAL_REQUEST_CHAR    ('c')
+#define CAL_REQUEST_TIME_MS (1000)
+#define CAL_POINT_READINGS  (16)
 
 #define IDLE_BLINK_PERIOD_MS    (15000)
 #define IDLE_BLINK_DURATION_MS  (100)
 
+//! Longest we'll wait for the display to finish before going into STOP. A
+//!   frame takes ~1.7ms.
+#define DISPLAY_FLUSH_TIMEOUT_MS  (5)
+
 //! Toggle heartbeat LED every 30 seconds
 #define HB_TICK_TIME_MS (30000)
 //! heartbeet LED is on for 0.1 seconds
@@ -50,9 +125,13 @@
 
 
 ADC_HandleTypeDef hadc1;      //!< HAL handle for ADC1
-DMA_HandleTypeDef hdma_adc1;  //!< HAL handle for DMA for ADC1. Currently not used.
+#if ADC_SIMULTANEOUS
+ADC_HandleTypeDef hadc2;      //!< HAL handle for ADC2. Converts vref alongside ADC1
+#endif
+DMA_HandleTypeDef hdma_adc1;  //!< HAL handle for DMA for ADC1. Moves each channel scan to memory
 I2C_HandleTypeDef hI2C3;      //!< HAL handle for I2C3 (display)
 RTC_HandleTypeDef hrtc;       //!< HAL handle for our RTC. Used to awake us from deep sleep
+TIM_HandleTypeDef htim2;      //!< HAL handle for TIM2. Paces continuous ADC sampling
 UART_HandleTypeDef huart4;    //!< HAL handle for UART4 for debug prints
 
 extern __IO uint32_t uwTick;  //!< HAL tick count
@@ -73,19 +152,34 @@ typedef enum {
 
 static e_main_modes mode = kIdleMode;  //!< global tracking main's state
 static uint8_t str_buff[64];  //!< buffer for transmitting data over UART
+static preheat_t preheat;     //!< fit of recent readings, for the preheat ETA
+static cycle_t cycle;         //!< thermostat cycle detector, fed every `ACTIVE_SAMPLE_TIME_MS`
+static render_deadband_t display_deadband;  //!< hysteresis on the displayed temperature
 
 /****  Private function definitions  ****/
 void blocking_delay(volatile uint32_t delay);
 void blinkLED_withDelay(uint32_t delay);
-void displayTemp(float temp, bool inFarenheit);
+void displayTemp(int32_t temp, bool inFarenheit);
+void displayETA(uint32_t seconds);
+void displayUpdate(int32_t temp_cC);
+void displayActive(int32_t temp_cC);
+#if RENDER_BENCHMARK
+void displayBenchmark(void);
+#endif
 void sleep_enterSleep(void);
-void sleep_enterStop(int timeToSleep_s);
+void sleep_enterStop(uint32_t timeToSleep_ms);
 static void SYSCLKConfig_STOP(void);
 
 // Modes
 void idleMode(void);
 void activeMode(void);
 void errMode(char * err_reason);
+#ifdef DEBUG
+bool calibrate_requested(uint32_t wait_ms);
+void calibrateMode(void);
+ret_t calibrate_readReference(int32_t * temp_cC);
+int32_t calibrate_measure(void);
+#endif
 
 
 #ifdef DEBUG
@@ -94,6 +188,9 @@ void errMode(char * err_reason);
 #else
     #define print_string(x)  /* Don't do anything. */
 #endif
+#if RENDER_BENCHMARK && !defined(DEBUG)
+#error "RENDER_BENCHMARK prints its results over the DEBUG UART"
+#endif
 
 
 /*! Main function. Initializes all peripherals needed, get's an initial thermocouple
@@ -102,6 +199,9 @@ void errMode(char * err_reason);
  */
 int main(void)
 {
+    cal_record_t cal;
+    bool calibrate = false;
+
     //! Reset of all peripherals, Initializes the Flash interface and the Systick.
     HAL_Init();
 
@@ -116,8 +216,14 @@ int main(void)
 #endif
 
     print_string("Hello World!\n");
+#if RENDER_BENCHMARK
+    displayBenchmark();
+#endif
 
+    hw_DMA_Init();  // Must come before the ADC so the DMA clock is running
     hw_ADC1_Init();
+    hw_ADC2_Init();
+    hw_TIM2_Init();
     hw_I2C3_Init();
     hw_RTC_Init();
 
@@ -133,7 +239,11 @@ int main(void)
     disp_writeDigit_ascii(3, ' ', false);
     disp_writeDisplay();
 
+#ifdef DEBUG
+    calibrate = calibrate_requested(CAL_REQUEST_TIME_MS);
+#else
     HAL_Delay(1000);
+#endif
 
     disp_writeDigit_raw(0, 0);
     disp_writeDigit_raw(1, 0);
@@ -142,6 +252,23 @@ int main(void)
     disp_writeDisplay();
 
     therm_init();
+    therm_setOversampling(IDLE_OVERSAMPLE_BITS);
+    therm_setWakeThreshold(ACTIVE_TEMP_THRESHOLD);
+    preheat_init(&preheat, ETA_WINDOW);
+    cycle_init(&cycle, ACTIVE_SAMPLE_TIME_MS);
+    render_deadbandInit(&display_deadband, DISPLAY_DEADBAND);
+
+    // This unit's amp calibration, from when it was built. Nominal without one.
+    if (cal_load(&cal) != RET_OK || therm_setCalibration(cal.gain, cal.offset) != RET_OK) {
+        print_string("No calibration record, using nominal\n");
+    }
+#ifdef DEBUG
+    if (calibrate) {
+        calibrateMode();
+    }
+#else
+    (void)calibrate;
+#endif
 
     //  Main infinite loop
     print_string("Entering Main\n");
@@ -163,7 +290,7 @@ int main(void)
                 // Write the reason for the error
                 errMode("TEMP");
                 if ( therm_valueReady() ) {
-                    if ( therm_getValue_single() < INSANE_TEMP_THRESHOLD ) {
+                    if ( therm_getValue_single_cC() < INSANE_TEMP_THRESHOLD ) {
                         mode = kActiveMode;
                     }
                 } else if ( !therm_ADCRunning() ) {
@@ -189,17 +316,72 @@ int main(void)
 
 void activeMode(void)
 {
-    float temperature = 0;
+    int32_t temperature = 0;
     static uint32_t time_for_reading = 0;
 
+#if ACTIVE_USE_TRACKER
+    static uint32_t time_for_display = 0;
+    static bool reading_scheduled = false;
+
+    if ( therm_valueReady() ) {
+        if ( !reading_scheduled ) {
+            // Fresh reading in the tracker. Come back once its estimate gets too fuzzy.
+            time_for_reading = HAL_GetTick() +
+                therm_timeUntilUncertain_ms(ACTIVE_MAX_UNCERTAINTY, ACTIVE_MAX_SAMPLE_TIME_MS);
+            reading_scheduled = true;
+            // Peek, don't take it: taking it clears therm_valueReady and starts another
+            preheat_push(&preheat, HAL_GetTick(), stats_latest(therm_getStats()));
+#ifdef DEBUG
+            sprintf((char *)str_buff, "Reading took %u conversions, next in %lu ms\n",
+                    therm_lastConversionCount(), (unsigned long)(time_for_reading - HAL_GetTick()));
+            print_string((char *)str_buff);
+#endif
+        } else if (HAL_GetTick() >= time_for_reading) {
+            reading_scheduled = false;
+            therm_startReading_adaptive();  // Convert until the reading settles
+        }
+    } else if ( !therm_ADCRunning() ) {
+        // If we're not running temp readings, do that!
+        therm_startReading_adaptive();
+    }
+
+    if ( therm_trackerValid() && HAL_GetTick() >= time_for_display ) {
+        time_for_display = HAL_GetTick() + ACTIVE_SAMPLE_TIME_MS;
+        temperature = therm_getEstimate_cC();
+
+        if (temperature < ACTIVE_TEMP_THRESHOLD) {
+            disp_clear();
+            disp_writeDisplay();
+#ifdef DEBUG
+            sprintf((char *)str_buff, "Display: %lu frames submitted, %lu sent\n",
+                    (unsigned long)disp_framesSubmitted(), (unsigned long)disp_framesSent());
+            print_string((char *)str_buff);
+#endif
+            mode = kIdleMode;
+            reading_scheduled = false;
+            therm_stopReading();
+            therm_setOversampling(IDLE_OVERSAMPLE_BITS);
+            therm_startReading_single();  // Single thermocouple conversion
+            return;
+        } else if (temperature > INSANE_TEMP_THRESHOLD) {
+            mode = kInsaneTempMode;
+            return;
+        } else {
+            displayActive(temperature);
+        }
+    }
+    // Nothing to do until the next display update, reading or ADC interrupt
+    sleep_enterSleep();
+#else
     if ( therm_valueReady() ) {
         if (HAL_GetTick() >= time_for_reading) {
-            temperature = therm_getValue_averaged();
+            temperature = therm_getValue_averaged_cC();
 
             if (temperature < ACTIVE_TEMP_THRESHOLD) {
                 disp_clear();
                 disp_writeDisplay();
                 mode = kIdleMode;
+                therm_setOversampling(IDLE_OVERSAMPLE_BITS);
                 time_for_reading = HAL_GetTick() + IDLE_SAMPLE_TIME_MS;
                 therm_startReading_single();  // Single thermocouple conversion
             } else if (temperature > INSANE_TEMP_THRESHOLD) {
@@ -207,8 +389,13 @@ void activeMode(void)
             } else {
                 // temperature at needed value. Display temp
                 time_for_reading = HAL_GetTick() + ACTIVE_SAMPLE_TIME_MS;
-                displayTemp(temperature, true);  // display temp in in farenheit
-                therm_startReading_single();  // Single thermocouple conversion
+                preheat_push(&preheat, HAL_GetTick(), temperature);
+                displayActive(temperature);
+#ifdef DEBUG
+                sprintf((char *)str_buff, "Reading took %u conversions\n", therm_lastConversionCount());
+                print_string((char *)str_buff);
+#endif
+                therm_startReading_adaptive();  // Convert until the reading settles
                 // deep sleep for a second to save power
                 // TODO: switch back to standby
                 sleep_enterSleep();
@@ -218,32 +405,68 @@ void activeMode(void)
         }
     } else if ( !therm_ADCRunning() ) {
         // If we're not running temp readings, do that!
-        therm_startReading_single();
+        therm_startReading_adaptive();
     } else {
         // Not done yet... Keep snoozin! ADC interrupt should wake us from SLEEP
         sleep_enterSleep();
     }
+#endif
 }
 
 
 void idleMode(void)
 {
-    float temperature;
+    int32_t temperature;
     static uint32_t time_for_blink = 0;
     static bool blink_on = false;
 
+#if IDLE_USE_ADC_WATCHDOG
+    (void)temperature;
+    // Drop anything left over from active mode, then let the hardware decide
+    therm_process();
+    if ( !therm_settled() ) {
+        // Woke up with the front end powering up. Give it the last ms or so.
+        therm_powerUp();
+        sleep_enterSleep();
+    } else if ( therm_aboveThreshold_watchdog() ) {
+        print_string("ADC watchdog tripped. Oven is on.\n");
+        mode = kActiveMode;
+        therm_resetTracker();  // whatever it knew is from before the oven was off
+        preheat_reset(&preheat);
+        cycle_reset(&cycle);
+        therm_setOversampling(ACTIVE_OVERSAMPLE_BITS);
+        therm_startReading_adaptive();  // Convert until the reading settles
+    } else if ( !therm_ADCRunning() ) {
+        // Power down the analog side and wake up early enough that it has
+        //   settled right when the next sample is due
+        therm_powerDown();
+        hw_RTC_setWakeup(IDLE_WAKE_TIME_MS);
+        sleep_enterStop(IDLE_WAKE_TIME_MS);
+        therm_powerUp();
+    } else {
+        // A reading from active mode is still going. ADC interrupt should wake us from SLEEP
+        sleep_enterSleep();
+    }
+#else
     if ( therm_valueReady() ) {
         print_string("Therm value ready. Check it out.\n");
-        temperature = therm_getValue_single();
+        temperature = therm_getValue_single_cC();
 
         if ( temperature >= ACTIVE_TEMP_THRESHOLD ) {
             mode = kActiveMode;
-            therm_startReading_single();  // Single thermocouple conversion
+            therm_resetTracker();  // whatever it knew is from before the oven was off
+            preheat_reset(&preheat);
+            cycle_reset(&cycle);
+            therm_setOversampling(ACTIVE_OVERSAMPLE_BITS);
+            therm_startReading_adaptive();  // Convert until the reading settles
         } else {
-            // Configure the RTC to wake us up in N miliseconds from standby
-            hw_RTC_setWakeup(IDLE_SAMPLE_TIME_MS);
-            sleep_enterStop(IDLE_SAMPLE_TIME_MS / 1000);  // This divide should be optimized out by compiler
-            // Start a single thermocouple read after we wake back up
+            // Power down the analog side and wake up early enough that it has
+            //   settled right when the next sample is due
+            therm_powerDown();
+            hw_RTC_setWakeup(IDLE_WAKE_TIME_MS);
+            sleep_enterStop(IDLE_WAKE_TIME_MS);
+            // Start a single thermocouple read after we wake back up. It kicks
+            //   off once the front end has settled.
             therm_startReading_single();
         }
     } else if ( !therm_ADCRunning() ) {
@@ -255,6 +478,7 @@ void idleMode(void)
         print_string("Sleep and wait for ADC...\n");
         sleep_enterSleep();
     }
+#endif
 
     disp_writeDigit_ascii(3, ' ', true);  // Turn on the blink
     disp_writeDisplay();
@@ -300,6 +524,139 @@ void errMode(char * err_reason)
 }
 
 
+#ifdef DEBUG
+/*! Listens on UART4 for `wait_ms` for someone asking to calibrate. Returns
+ *   true if they did.
+ */
+bool calibrate_requested(uint32_t wait_ms)
+{
+    uint32_t start = HAL_GetTick();
+    uint8_t c;
+
+    while (HAL_GetTick() - start < wait_ms) {
+        if (HAL_UART_Receive(&huart4, &c, 1, wait_ms - (HAL_GetTick() - start)) == HAL_OK &&
+            c == CAL_REQUEST_CHAR) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/*! Captures both points of a two-point calibration over UART4, solves it and
+ *   stores it. Blocks until it's done. Nothing is stored unless both points
+ *   were good, so it can be bailed out of by resetting.
+ */
+void calibrateMode(void)
+{
+    therm_cal_point_t points[2];
+    cal_record_t record;
+    int32_t reference, measured;
+    ret_t ret;
+
+    disp_writeDigit_ascii(0, 'C', false);
+    disp_writeDigit_ascii(1, 'A', false);
+    disp_writeDigit_ascii(2, 'L', false);
+    disp_writeDigit_ascii(3, ' ', false);
+    disp_writeDisplay();
+    therm_setOversampling(ACTIVE_OVERSAMPLE_BITS);
+
+    for (uint8_t i = 0; i < 2; ) {
+        sprintf((char *)str_buff, "Cal: probe at the %s point, enter its temp in C\n",
+                i == 0 ? "low" : "high");
+        print_string((char *)str_buff);
+        if (calibrate_readReference(&reference) != RET_OK) {
+            print_string("Cal: didn't get that, try again\n");
+            continue;
+        }
+        disp_writeDigit_ascii(3, '1' + i, false);
+        disp_writeDisplay();
+        measured = calibrate_measure();
+        therm_captureCalPoint(reference, measured, &points[i]);
+        sprintf((char *)str_buff, "Cal: reference %ld cC, measured %ld cC\n",
+                (long)reference, (long)measured);
+        print_string((char *)str_buff);
+        i++;
+    }
+
+    ret = therm_solveCalibration(&points[0], &points[1], &record.gain, &record.offset);
+    if (ret == RET_OK) {
+        ret = cal_store(&record);
+    }
+    if (ret == RET_OK) {
+        ret = therm_setCalibration(record.gain, record.offset);
+    }
+    sprintf((char *)str_buff, "Cal: gain %ld, offset %ld -> %i\n",
+            (long)record.gain, (long)record.offset, ret);
+    print_string((char *)str_buff);
+
+    therm_setOversampling(IDLE_OVERSAMPLE_BITS);
+    disp_clear();
+    disp_writeDisplay();
+}
+
+/*! Reads a temperature typed over UART4, in C with up to two decimals, into
+ *   centi-degrees. Echoes it back. Waits as long as it takes for the line.
+ */
+ret_t calibrate_readReference(int32_t * temp_cC)
+{
+    int32_t value = 0;
+    int8_t decimals = -1;  // -1 until the '.'
+    bool negative = false;
+    bool any = false;
+    uint8_t c;
+
+    while (1) {
+        if (HAL_UART_Receive(&huart4, &c, 1, HAL_MAX_DELAY) != HAL_OK) {
+            return RET_COM_ERR;
+        }
+        (void)HAL_UART_Transmit(&huart4, &c, 1, 10);
+        if (c == '\r' || c == '\n') {
+            if (any) {
+                break;
+            }
+        } else if (c == '-' && !any && !negative) {
+            negative = true;
+        } else if (c == '.' && decimals < 0) {
+            decimals = 0;
+        } else if (c >= '0' && c <= '9' && decimals < 2 && value < 100000) {
+            value = value * 10 + (c - '0');
+            any = true;
+            if (decimals >= 0) {
+                decimals++;
+            }
+        } else {
+            return RET_VAL_ERR;
+        }
+    }
+
+    if (decimals < 0) {
+        decimals = 0;
+    }
+    for (; decimals < 2; decimals++) {
+        value *= 10;
+    }
+    *temp_cC = negative ? -value : value;
+    return RET_OK;
+}
+
+/*! Averages `CAL_POINT_READINGS` adaptive readings, in centi-degrees.
+ */
+int32_t calibrate_measure(void)
+{
+    int64_t sum = 0;
+
+    for (uint16_t i = 0; i < CAL_POINT_READINGS; i++) {
+        therm_startReading_adaptive();
+        while ( !therm_valueReady() ) {
+            sleep_enterSleep();
+        }
+        sum += therm_getValue_single_cC();
+    }
+    return (int32_t)(sum / CAL_POINT_READINGS);
+}
+#endif
+
+
 void sleep_enterSleep(void)
 {
     print_string("Entering sleep...\n");
@@ -308,18 +665,19 @@ void sleep_enterSleep(void)
 }
 
 
-void sleep_enterStop(int timeToSleep_s)
+void sleep_enterStop(uint32_t timeToSleep_ms)
 {
     GPIO_InitTypeDef GPIO_InitStruct;
 
     print_string("Entering STOP...\n");
-    HAL_Delay(250);
     // Clear LEDs and display
     hw_LED_setValue(0);
     for (int i=0; i<4; i++) {
         disp_writeDigit_ascii(i, ' ', false);
     }
     disp_writeDisplay();
+    // I2C3 stops along with everything else, so let the frame finish first
+    (void)disp_flush(DISPLAY_FLUSH_TIMEOUT_MS);
 
     /* Disable USB Clock */
     __HAL_RCC_USB_OTG_FS_CLK_DISABLE();
@@ -340,7 +698,10 @@ void sleep_enterStop(int timeToSleep_s)
     GPIO_InitStruct.Pull = GPIO_NOPULL;
     GPIO_InitStruct.Pin = GPIO_PIN_All;
     HAL_GPIO_Init(GPIOA, &GPIO_InitStruct);
+    // Keep driving the analog front end off. A floating enable turns it on.
+    GPIO_InitStruct.Pin = GPIO_PIN_All & ~AFE_EN_PIN;
     HAL_GPIO_Init(GPIOB, &GPIO_InitStruct);
+    GPIO_InitStruct.Pin = GPIO_PIN_All;
     HAL_GPIO_Init(GPIOC, &GPIO_InitStruct);
     HAL_GPIO_Init(GPIOD, &GPIO_InitStruct);
     HAL_GPIO_Init(GPIOE, &GPIO_InitStruct);
@@ -375,7 +736,7 @@ void sleep_enterStop(int timeToSleep_s)
     HAL_RTCEx_DeactivateWakeUpTimer(&hrtc);
 
     /* Enable Wake-up timer */
-    HAL_RTCEx_SetWakeUpTimer_IT(&hrtc, 0x0801 * timeToSleep_s, RTC_WAKEUPCLOCK_RTCCLK_DIV16);
+    HAL_RTCEx_SetWakeUpTimer_IT(&hrtc, (0x0801 * timeToSleep_ms) / 1000, RTC_WAKEUPCLOCK_RTCCLK_DIV16);
 
     /* FLASH Deep Power Down Mode enabled */
     HAL_PWREx_EnableFlashPowerDown();
@@ -399,48 +760,126 @@ void sleep_enterStop(int timeToSleep_s)
 }
 
 
-/*! This function takes in a positive, floating point value from [0, 1000) and
- *   displays it on the four digit display we have with the most percision possible.
+/*! Feeds a fresh active mode temperature to the cycle detector and puts it,
+ *   or once the oven's holding temperature the mean across cycles, on the
+ *   display. Called every `ACTIVE_SAMPLE_TIME_MS`.
  */
-void displayTemp(float temp, bool inFarenheit)
+void displayActive(int32_t temp_cC)
 {
-    uint8_t a,b,c,d = 0;
-
-    if (inFarenheit) {
-        temp = temp * 1.8f + 32.0f;
+    static uint32_t time_for_steady_display = 0;
+
+    cycle_push(&cycle, temp_cC);
+    if ( !cycle_steady(&cycle) ) {
+        displayUpdate(temp_cC);
+    } else if ( HAL_GetTick() >= time_for_steady_display ) {
+        time_for_steady_display = HAL_GetTick() + STEADY_DISPLAY_TIME_MS;
+        displayUpdate(cycle_mean(&cycle));
     }
-    if (temp < 100) {
-        a = (uint8_t)(((uint32_t)temp % 100) / 10);    // 10's place
-        b = (uint8_t)((uint32_t)temp % 10);            // 1's place
-        c = (uint8_t)((uint32_t)(temp * 10.0f) % 10);  // 10ths place
-        d = (uint8_t)((uint32_t)(temp * 100.0f) % 10); // 100ths place
-
-        // Write the dot out
-        disp_writeDigit_value(1, b, true);
-        disp_writeDigit_value(2, c, false);
+}
+
+
+/*! Shows the temperature, or every other time while the oven is heating up
+ *   towards `ETA_TARGET_TEMP`, how long until it gets there.
+ */
+void displayUpdate(int32_t temp_cC)
+{
+    static bool show_eta = false;
+    uint32_t eta_s;
+    uint8_t confidence;
+
+    show_eta = !show_eta;
+    if ( show_eta &&
+         preheat_eta(&preheat, ETA_TARGET_TEMP, HAL_GetTick(), &eta_s, &confidence) == RET_OK &&
+         confidence >= ETA_MIN_CONFIDENCE ) {
+        displayETA(eta_s);
     } else {
-        a = (uint8_t)(((uint32_t)temp % 1000) / 100);  // 100's place
-        b = (uint8_t)(((uint32_t)temp % 100) / 10);    // 10's place
-        c = (uint8_t)((uint32_t)temp % 10);            // 1's place
-        d = (uint8_t)((uint32_t)(temp * 10.0f) % 10);  // 10ths place
-
-        // Write the dot out
-        disp_writeDigit_value(1, b, false);
-        disp_writeDigit_value(2, c, true);
+        displayTemp(temp_cC, true);  // display temp in in farenheit
     }
+}
 
-    //write out the rest
-    if (temp < 10) {
-        disp_writeDigit_raw(0, 0);  // Clear this section
+
+/*! Shows a time as "4m05" (minutes, then seconds) under 10 minutes, or "12m "
+ *   (just minutes) up to 99.
+ */
+void displayETA(uint32_t seconds)
+{
+    uint32_t minutes = seconds / 60;
+
+    if (minutes > 99) {
+        minutes = 99;
+    }
+    if (minutes < 10) {
+        seconds %= 60;
+        disp_writeDigit_value(0, (uint8_t)minutes, false);
+        disp_writeDigit_ascii(1, 'm', false);
+        disp_writeDigit_value(2, (uint8_t)(seconds / 10), false);
+        disp_writeDigit_value(3, (uint8_t)(seconds % 10), false);
     } else {
-        disp_writeDigit_value(0, a, false);
+        disp_writeDigit_value(0, (uint8_t)(minutes / 10), false);
+        disp_writeDigit_value(1, (uint8_t)(minutes % 10), false);
+        disp_writeDigit_ascii(2, 'm', false);
+        disp_writeDigit_ascii(3, ' ', false);
     }
-    disp_writeDigit_value(3, d, false);
+    disp_writeDisplay();
+}
+
 
+/*! This function takes in a temperature in centi-degrees celsius and displays
+ *   it on the four digit display we have with the most percision possible,
+ *   clamped to [0, 1000). See `render_centi`. It goes through
+ *   `display_deadband` first, and the display driver only sends what changed,
+ *   so a reading that's just jittering doesn't touch the bus at all.
+ */
+void displayTemp(int32_t temp, bool inFarenheit)
+{
+    render_frame_t frame;
+
+    if (inFarenheit) {
+        temp = c2f_centi(temp);
+    }
+    temp = render_deadband(&display_deadband, temp);
+    render_centi(temp < 0 ? 0 : (uint32_t)temp, &frame);
+    disp_writeFrame(&frame);
     disp_writeDisplay();
 }
 
 
+#if RENDER_BENCHMARK
+/*! Times `render_centi` against `render_float` (what `displayTemp` used to
+ *   do) with the DWT cycle counter, over every reading the display can show,
+ *   and prints the average cycles each took. Only built with
+ *   `RENDER_BENCHMARK`, since it holds up boot for a good fraction of a
+ *   second. `make bench` does the same on the host.
+ */
+void displayBenchmark(void)
+{
+    render_frame_t frame;
+    uint32_t start, table_cycles, float_cycles;
+
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+    start = DWT->CYCCNT;
+    for (uint32_t centi = 0; centi <= RENDER_MAX_CENTI; centi++) {
+        render_float(centi * 0.01f, &frame);
+    }
+    float_cycles = DWT->CYCCNT - start;
+
+    start = DWT->CYCCNT;
+    for (uint32_t centi = 0; centi <= RENDER_MAX_CENTI; centi++) {
+        render_centi(centi, &frame);
+    }
+    table_cycles = DWT->CYCCNT - start;
+
+    sprintf((char *)str_buff, "Render: float %lu, table %lu cycles each\n",
+            (unsigned long)(float_cycles / (RENDER_MAX_CENTI + 1)),
+            (unsigned long)(table_cycles / (RENDER_MAX_CENTI + 1)));
+    print_string((char *)str_buff);
+}
+#endif
+
+
 /**
   * @brief  This function is executed in case of error occurrence.
   * @param  None
@@ -0,0 +1,211 @@
+/*!
+ * @file    median.c
+ * @author  Tyler Holmes
+ * @date    16-Oct-2026
+ * @brief   Sliding window median / Hampel spike rejection.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "common.h"
+#include "median.h"
+
+//! Fewest samples the window needs before anything is judged against it
+#define MEDIAN_MIN_JUDGE  (3)
+
+/*! For normally distributed samples, sigma = IQR / 1.349. This is 1 / 1.349 in
+ *   Q8 (190 / 256 = 0.742).
+ */
+#define MEDIAN_IQR_TO_SIGMA_Q8  (190)
+
+
+// Private function definitions
+static bool median_before(const median_t * filter, uint8_t a, uint8_t b);
+static void median_insert(median_t * filter, uint8_t node);
+static void median_remove(median_t * filter, uint8_t node);
+static int32_t median_at(const median_t * filter, uint16_t rank);
+
+
+/*! Sets up `filter` over the last `window` samples (0 to pass everything
+ *   through). A sample more than `threshold_tenths` / 10 standard deviations
+ *   from the median is an outlier, unless it's within `min_deviation` of it.
+ *   Sigma comes from the interquartile range, so the spikes themselves don't
+ *   inflate it.
+ */
+ret_t median_init(median_t * filter, uint16_t window, uint16_t threshold_tenths, int32_t min_deviation)
+{
+    if (window > MEDIAN_MAX_WINDOW || (window != 0 && window < 3) || min_deviation < 0) {
+        return RET_INVALID_ARGS_ERR;
+    }
+    filter->window = window;
+    filter->threshold = threshold_tenths;
+    filter->min_deviation = min_deviation;
+    filter->random = 0x2545F491;
+    median_reset(filter);
+    return RET_OK;
+}
+
+/*! Throws away every sample in the window and the rejection count.
+ */
+void median_reset(median_t * filter)
+{
+    for (uint8_t level = 0; level < MEDIAN_LEVELS; level++) {
+        filter->nodes[0].next[level] = MEDIAN_NIL;
+        filter->nodes[0].width[level] = 1;
+    }
+    filter->nodes[0].levels = MEDIAN_LEVELS;
+    filter->count = 0;
+    filter->head = 0;
+    filter->rejected = 0;
+}
+
+/*! Runs `sample` through the filter. Returns it as is, or the median of the
+ *   window if it's an outlier. Either way the raw sample goes into the window,
+ *   so a real step gets through once it's half of the window. Samples are
+ *   judged against a partly full window too, once it has `MEDIAN_MIN_JUDGE`
+ *   in it. With 3 the quartiles are just the smallest and largest.
+ */
+int32_t median_filter(median_t * filter, int32_t sample)
+{
+    int32_t output = sample;
+
+    if (filter->window == 0) {
+        return sample;
+    }
+
+    if (filter->count >= MEDIAN_MIN_JUDGE) {
+        int32_t median = median_get(filter);
+        int32_t iqr = median_at(filter, (3 * filter->count) / 4) -
+                      median_at(filter, filter->count / 4);
+        int64_t deviation = sample > median ? (int64_t)sample - median : (int64_t)median - sample;
+
+        // deviation > threshold / 10 * iqr * 190 / 256, without the divides
+        if (deviation > filter->min_deviation &&
+            deviation * 10 * 256 > (int64_t)filter->threshold * iqr * MEDIAN_IQR_TO_SIGMA_Q8) {
+            output = median;
+            filter->rejected++;
+        }
+    }
+    if (filter->count == filter->window) {
+        // Age out the oldest, whose node this one reuses
+        median_remove(filter, (uint8_t)(filter->head + 1));
+    }
+
+    filter->nodes[filter->head + 1].value = sample;
+    median_insert(filter, (uint8_t)(filter->head + 1));
+    filter->head = (filter->head + 1) % filter->window;
+    return output;
+}
+
+/*! Returns the median of the window. Only meaningful once there's a sample.
+ */
+int32_t median_get(const median_t * filter)
+{
+    return median_at(filter, filter->count / 2);
+}
+
+/*! Returns how many outliers have been replaced since the last reset.
+ */
+uint32_t median_rejected(const median_t * filter)
+{
+    return filter->rejected;
+}
+
+/*! Private function that orders nodes by value, and nodes holding the same
+ *   value by index, so every node has one place in the list.
+ */
+static bool median_before(const median_t * filter, uint8_t a, uint8_t b)
+{
+    int32_t a_value = filter->nodes[a].value;
+    int32_t b_value = filter->nodes[b].value;
+
+    return a_value < b_value || (a_value == b_value && a < b);
+}
+
+/*! Private function that links `node`, value already set, into its place in
+ *   the skip list. It goes up a level with probability 1/2 each time, so on
+ *   average the levels halve and the walk down is O(log n).
+ */
+static void median_insert(median_t * filter, uint8_t node)
+{
+    median_node_t * nodes = filter->nodes;
+    uint8_t chain[MEDIAN_LEVELS];   // last node before `node` at each level
+    uint8_t steps[MEDIAN_LEVELS];   // samples stepped over at each level
+    uint8_t current = 0;
+    uint8_t levels = 1;
+    uint8_t below = 0;
+
+    for (int8_t level = MEDIAN_LEVELS - 1; level >= 0; level--) {
+        steps[level] = 0;
+        while (nodes[current].next[level] != MEDIAN_NIL &&
+               median_before(filter, nodes[current].next[level], node)) {
+            steps[level] += nodes[current].width[level];
+            current = nodes[current].next[level];
+        }
+        chain[level] = current;
+    }
+
+    filter->random ^= filter->random << 13;
+    filter->random ^= filter->random >> 17;
+    filter->random ^= filter->random << 5;
+    while (levels < MEDIAN_LEVELS && (filter->random >> levels) & 1) {
+        levels++;
+    }
+    nodes[node].levels = levels;
+
+    for (uint8_t level = 0; level < levels; level++) {
+        median_node_t * prev = &nodes[chain[level]];
+
+        nodes[node].next[level] = prev->next[level];
+        prev->next[level] = node;
+        nodes[node].width[level] = (uint8_t)(prev->width[level] - below);
+        prev->width[level] = (uint8_t)(below + 1);
+        below += steps[level];
+    }
+    for (uint8_t level = levels; level < MEDIAN_LEVELS; level++) {
+        nodes[chain[level]].width[level]++;
+    }
+    filter->count++;
+}
+
+/*! Private function that unlinks `node` from the skip list.
+ */
+static void median_remove(median_t * filter, uint8_t node)
+{
+    median_node_t * nodes = filter->nodes;
+    uint8_t current = 0;
+
+    for (int8_t level = MEDIAN_LEVELS - 1; level >= 0; level--) {
+        while (nodes[current].next[level] != MEDIAN_NIL &&
+               median_before(filter, nodes[current].next[level], node)) {
+            current = nodes[current].next[level];
+        }
+        if (level < nodes[node].levels) {
+            nodes[current].width[level] += nodes[node].width[level] - 1;
+            nodes[current].next[level] = nodes[node].next[level];
+        } else {
+            nodes[current].width[level]--;
+        }
+    }
+    filter->count--;
+}
+
+/*! Private function that returns the `rank`-th smallest sample in the window,
+ *   counting from 0, by adding up link widths on the way down.
+ */
+static int32_t median_at(const median_t * filter, uint16_t rank)
+{
+    const median_node_t * nodes = filter->nodes;
+    uint8_t current = 0;
+    uint16_t remaining = rank + 1;
+
+    for (int8_t level = MEDIAN_LEVELS - 1; level >= 0; level--) {
+        while (nodes[current].next[level] != MEDIAN_NIL &&
+               nodes[current].width[level] <= remaining) {
+            remaining -= nodes[current].width[level];
+            current = nodes[current].next[level];
+        }
+    }
+    return nodes[current].value;
+}
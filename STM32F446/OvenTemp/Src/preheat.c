@@ -0,0 +1,159 @@
+/*!
+ * @file    preheat.c
+ * @author  Tyler Holmes
+ * @date    16-Oct-2026
+ * @brief   Preheat ETA from a sliding least squares fit of recent readings.
+ */
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "common.h"
+#include "preheat.h"
+
+//! Longest ETA we'll give, in seconds. Past that it's not really heating.
+#define PREHEAT_MAX_ETA_S  (99UL * 60)
+
+
+// Private function definitions
+static bool preheat_fit(const preheat_t * fit, float * slope, float * intercept, float * slope_se);
+
+
+/*! Sets up `fit` to use the last `window` readings.
+ */
+ret_t preheat_init(preheat_t * fit, uint16_t window)
+{
+    if (window < PREHEAT_MIN_POINTS || window > PREHEAT_MAX_WINDOW) {
+        return RET_INVALID_ARGS_ERR;
+    }
+    fit->window = window;
+    preheat_reset(fit);
+    return RET_OK;
+}
+
+/*! Throws away every reading, say when the oven's just been turned on.
+ */
+void preheat_reset(preheat_t * fit)
+{
+    fit->count = 0;
+    fit->head = 0;
+    fit->start_tick = 0;
+    fit->sum_t = 0;
+    fit->sum_y = 0;
+    fit->sum_tt = 0;
+    fit->sum_ty = 0;
+    fit->sum_yy = 0;
+}
+
+/*! Adds a reading of `temp` centi-degrees taken at HAL tick `tick`, pushing
+ *   the oldest one out once the window is full.
+ */
+void preheat_push(preheat_t * fit, uint32_t tick, int32_t temp)
+{
+    preheat_point_t * point = &fit->points[fit->head];
+    int32_t time;
+
+    if (fit->count == 0) {
+        fit->start_tick = tick;
+    }
+    time = (int32_t)((tick - fit->start_tick) / 100);
+
+    if (fit->count == fit->window) {
+        fit->sum_t -= point->time;
+        fit->sum_y -= point->temp;
+        fit->sum_tt -= (int64_t)point->time * point->time;
+        fit->sum_ty -= (int64_t)point->time * point->temp;
+        fit->sum_yy -= (int64_t)point->temp * point->temp;
+    } else {
+        fit->count++;
+    }
+
+    point->time = time;
+    point->temp = temp;
+    fit->sum_t += time;
+    fit->sum_y += temp;
+    fit->sum_tt += (int64_t)time * time;
+    fit->sum_ty += (int64_t)time * temp;
+    fit->sum_yy += (int64_t)temp * temp;
+    fit->head = (fit->head + 1) % fit->window;
+}
+
+/*! Returns how fast the oven is heating, in centi-degrees per minute. 0 until
+ *   there are enough readings.
+ */
+int32_t preheat_rate(const preheat_t * fit)
+{
+    float slope, intercept, slope_se;
+
+    if (!preheat_fit(fit, &slope, &intercept, &slope_se)) {
+        return 0;
+    }
+    return (int32_t)lroundf(slope * 600.0f);
+}
+
+/*! Works out how many seconds from HAL tick `tick` until the oven gets to
+ *   `target` centi-degrees, going by the line through the recent readings.
+ *   `confidence` (0 - 100) is how sure we are of that: 100 minus the relative
+ *   error of the heating rate, in percent. Returns `RET_NODATA_ERR` if there
+ *   aren't enough readings, or `RET_VAL_ERR` if we're not heating towards the
+ *   target (already past it, flat, or cooling).
+ */
+ret_t preheat_eta(const preheat_t * fit, int32_t target, uint32_t tick,
+                  uint32_t * eta_s, uint8_t * confidence)
+{
+    float slope, intercept, slope_se;
+    float now, remaining, eta, rel_err;
+
+    if (!preheat_fit(fit, &slope, &intercept, &slope_se)) {
+        return RET_NODATA_ERR;
+    }
+    now = (float)(tick - fit->start_tick) / 100.0f;
+    remaining = (float)target - (intercept + slope * now);
+    if (slope <= 0.0f || remaining <= 0.0f) {
+        return RET_VAL_ERR;
+    }
+
+    eta = remaining / slope / 10.0f;  // deciseconds to seconds
+    if (eta > (float)PREHEAT_MAX_ETA_S) {
+        return RET_VAL_ERR;
+    }
+    rel_err = slope_se / slope;
+    *eta_s = (uint32_t)lroundf(eta);
+    *confidence = rel_err >= 1.0f ? 0 : (uint8_t)lroundf(100.0f * (1.0f - rel_err));
+    return RET_OK;
+}
+
+/*! Private function that fits the line. The sums are exact integers, so the
+ *   centered sums of squares come out of them without any cancellation; only
+ *   the last few steps are floating point, and single precision at that, since
+ *   the M4's FPU has no doubles. Returns false if there aren't enough readings
+ *   or they're all at the same time.
+ */
+static bool preheat_fit(const preheat_t * fit, float * slope, float * intercept, float * slope_se)
+{
+    int64_t n = fit->count;
+    int64_t sxx, sxy, syy;
+    float sse;
+
+    if (n < PREHEAT_MIN_POINTS) {
+        return false;
+    }
+    // n times the centered sums
+    sxx = n * fit->sum_tt - fit->sum_t * fit->sum_t;
+    sxy = n * fit->sum_ty - fit->sum_t * fit->sum_y;
+    syy = n * fit->sum_yy - fit->sum_y * fit->sum_y;
+    if (sxx <= 0) {
+        return false;
+    }
+
+    *slope = (float)sxy / (float)sxx;
+    *intercept = ((float)fit->sum_y - *slope * (float)fit->sum_t) / (float)n;
+    sse = ((float)syy - (float)sxy * *slope) / (float)n;
+    if (sse < 0.0f) {
+        sse = 0.0f;
+    }
+    // se(slope)^2 = sse / (n - 2) / centered sxx
+    *slope_se = sqrtf(sse / (float)(n - 2) / ((float)sxx / (float)n));
+    return true;
+}
@@ -0,0 +1,107 @@
+/*!
+ * @file    render.c
+ * @author  Tyler Holmes
+ * @date    16-Oct-2026
+ * @brief   Turns fixed point temperatures into digits for the quad alphanumeric display.
+ */
+
+#include <stdint.h>
+
+#include "font.h"
+#include "render.h"
+
+//! Packed BCD of `t`0 to `t`9: tens in the high nibble, ones in the low
+#define RENDER_BCD_ROW(t)  0x##t##0, 0x##t##1, 0x##t##2, 0x##t##3, 0x##t##4, \
+                           0x##t##5, 0x##t##6, 0x##t##7, 0x##t##8, 0x##t##9
+
+//! 0 to 99 as two BCD digits
+static const uint8_t render_bcd[100] = {
+    RENDER_BCD_ROW(0), RENDER_BCD_ROW(1), RENDER_BCD_ROW(2), RENDER_BCD_ROW(3),
+    RENDER_BCD_ROW(4), RENDER_BCD_ROW(5), RENDER_BCD_ROW(6), RENDER_BCD_ROW(7),
+    RENDER_BCD_ROW(8), RENDER_BCD_ROW(9),
+};
+
+
+/*! Renders `centi` hundredths (of a degree, usually) with the most precision
+ *   the four digits have: "12.34" below 100, "123.4" from there up to 999.9,
+ *   where it clamps. A leading zero is left blank. Two divides by 100 (which
+ *   the compiler makes multiplies) and two table lookups give all five BCD
+ *   digits packed into one word; the range just picks which four of them
+ *   show, so there's no per digit branching or dividing. Each digit is then
+ *   one font lookup, and the point is lit in the same pass.
+ */
+void render_centi(uint32_t centi, render_frame_t * frame)
+{
+    uint32_t high, hundreds, packed, range;
+
+    if (centi > RENDER_MAX_CENTI) {
+        centi = RENDER_MAX_CENTI;
+    }
+    high = centi / 100;
+    hundreds = high / 100;
+    packed = (hundreds << 16) | ((uint32_t)render_bcd[high - hundreds * 100] << 8) |
+             render_bcd[centi - high * 100];
+
+    // 0 shows digits 10s to 100ths, 1 shows 100s to 10ths
+    range = hundreds != 0;
+    packed >>= 4 * range;
+    frame->glyphs[0] = alphafonttable[packed < 0x1000 ? ' ' : '0' + (packed >> 12)];
+    frame->glyphs[1] = alphafonttable['0' + ((packed >> 8) & 0xF)];
+    frame->glyphs[2] = alphafonttable['0' + ((packed >> 4) & 0xF)];
+    frame->glyphs[3] = alphafonttable['0' + (packed & 0xF)];
+    frame->point = (uint8_t)(1 + range);
+    frame->glyphs[frame->point] |= FONT_POINT_MASK;
+}
+
+/*! Sets up `deadband` to hold values until they move `band` or more. A band
+ *   of 0 lets everything through.
+ */
+void render_deadbandInit(render_deadband_t * deadband, int32_t band)
+{
+    deadband->band = band < 0 ? 0 : band;
+    deadband->shown = 0;
+    deadband->valid = false;
+}
+
+/*! Returns what to show for `value`: itself if it's moved `band` or more from
+ *   what was shown last (or it's the first), otherwise what was shown last.
+ */
+int32_t render_deadband(render_deadband_t * deadband, int32_t value)
+{
+    int32_t change = value - deadband->shown;
+
+    if (!deadband->valid || change >= deadband->band || change <= -deadband->band) {
+        deadband->shown = value;
+        deadband->valid = true;
+    }
+    return deadband->shown;
+}
+
+#if RENDER_BENCHMARK
+/*! The old float way of doing `render_centi`, from when `displayTemp` took
+ *   degrees as a float. Only here to benchmark against.
+ */
+void render_float(float temp, render_frame_t * frame)
+{
+    uint8_t a, b, c, d;
+
+    if (temp < 100) {
+        a = (uint8_t)(((uint32_t)temp % 100) / 10);    // 10's place
+        b = (uint8_t)((uint32_t)temp % 10);            // 1's place
+        c = (uint8_t)((uint32_t)(temp * 10.0f) % 10);  // 10ths place
+        d = (uint8_t)((uint32_t)(temp * 100.0f) % 10); // 100ths place
+        frame->point = 1;
+    } else {
+        a = (uint8_t)(((uint32_t)temp % 1000) / 100);  // 100's place
+        b = (uint8_t)(((uint32_t)temp % 100) / 10);    // 10's place
+        c = (uint8_t)((uint32_t)temp % 10);            // 1's place
+        d = (uint8_t)((uint32_t)(temp * 10.0f) % 10);  // 10ths place
+        frame->point = 2;
+    }
+    frame->glyphs[0] = temp < 10 ? 0 : alphafonttable['0' + a];
+    frame->glyphs[1] = alphafonttable['0' + b];
+    frame->glyphs[2] = alphafonttable['0' + c];
+    frame->glyphs[3] = alphafonttable['0' + d];
+    frame->glyphs[frame->point] |= FONT_POINT_MASK;
+}
+#endif
@@ -0,0 +1,85 @@
+/*!
+ * @file    sample_queue.c
+ * @author  Tyler Holmes
+ * @date    16-Oct-2026
+ * @brief   Lock-free single-producer / single-consumer queue of ADC samples.
+ *
+ *      The head and tail are free running counts that are only ever written by
+ *      one side, and 32 bit aligned accesses are atomic on the M4. The data
+ *      memory barriers make sure a record is written before the producer
+ *      publishes it, and read before the consumer hands its slot back.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "sample_queue.h"
+#include "stm32f4xx_hal.h"
+
+#define SAMPLEQ_MASK  (SAMPLEQ_LEN - 1)
+
+#if (SAMPLEQ_LEN & SAMPLEQ_MASK) != 0
+    #error "SAMPLEQ_LEN must be a power of 2"
+#endif
+
+
+/*! Empties the queue. Only call this while neither side is using it.
+ */
+void sampleq_init(sampleq_t * q)
+{
+    q->head = 0;
+    q->tail = 0;
+    q->dropped = 0;
+}
+
+/*! Producer side. Copies `sample` into the queue. Returns false (and counts the
+ *   sample as dropped) if the consumer hasn't kept up and it's full.
+ */
+bool sampleq_push(sampleq_t * q, const therm_sample_t * sample)
+{
+    uint32_t head = q->head;
+
+    if (head - q->tail >= SAMPLEQ_LEN) {
+        q->dropped++;
+        return false;
+    }
+    q->records[head & SAMPLEQ_MASK] = *sample;
+    __DMB();  // record must land before it's published
+    q->head = head + 1;
+    return true;
+}
+
+/*! Consumer side. Copies up to `max_samples` of the oldest samples to `out`,
+ *   oldest first, and returns how many it got. Each sample comes out exactly once.
+ */
+uint32_t sampleq_pop(sampleq_t * q, therm_sample_t * out, uint32_t max_samples)
+{
+    uint32_t tail = q->tail;
+    uint32_t available = q->head - tail;
+    uint32_t i;
+
+    __DMB();  // don't read records before we've seen the head that published them
+    if (available > max_samples) {
+        available = max_samples;
+    }
+    for (i = 0; i < available; i++) {
+        out[i] = q->records[(tail + i) & SAMPLEQ_MASK];
+    }
+    __DMB();  // finish reading before handing the slots back
+    q->tail = tail + available;
+    return available;
+}
+
+/*! Returns how many samples are waiting. Safe from either side.
+ */
+uint32_t sampleq_count(const sampleq_t * q)
+{
+    return q->head - q->tail;
+}
+
+/*! Returns how many samples were dropped because the queue was full.
+ */
+uint32_t sampleq_dropped(const sampleq_t * q)
+{
+    return q->dropped;
+}
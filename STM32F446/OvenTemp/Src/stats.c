@@ -0,0 +1,179 @@
+/*!
+ * @file    stats.c
+ * @author  Tyler Holmes
+ * @date    16-Oct-2026
+ * @brief   Streaming statistics over a sliding window of integer samples.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "common.h"
+#include "stats.h"
+
+
+// Private function definitions
+static void stats_extreme_push(stats_extreme_t * q, uint32_t seq, int32_t value, bool is_min);
+static void stats_extreme_expire(stats_extreme_t * q, uint32_t oldest_seq);
+
+
+/*! Sets up `stats` to track the last `window` samples.
+ */
+ret_t stats_init(stats_t * stats, uint16_t window)
+{
+    if (window == 0 || window > STATS_MAX_WINDOW) {
+        return RET_INVALID_ARGS_ERR;
+    }
+    stats->window = window;
+    stats_reset(stats);
+    return RET_OK;
+}
+
+/*! Throws away every sample in the window, keeping its length.
+ */
+void stats_reset(stats_t * stats)
+{
+    stats->count = 0;
+    stats->head = 0;
+    stats->seq = 0;
+    stats->sum = 0;
+    stats->sum_sq = 0;
+    stats->min.head = 0;
+    stats->min.len = 0;
+    stats->max.head = 0;
+    stats->max.len = 0;
+}
+
+/*! Adds `value` to the window, dropping the oldest sample if it's full.
+ */
+void stats_push(stats_t * stats, int32_t value)
+{
+    if (stats->count == stats->window) {
+        int32_t oldest = stats->samples[stats->head];
+        stats->sum -= oldest;
+        stats->sum_sq -= (int64_t)oldest * oldest;
+    } else {
+        stats->count++;
+    }
+    stats->samples[stats->head] = value;
+    stats->sum += value;
+    stats->sum_sq += (int64_t)value * value;
+
+    stats->head++;
+    if (stats->head >= stats->window) {
+        stats->head = 0;
+    }
+
+    // Expire first: the queues only hold `STATS_MAX_WINDOW` entries, and with
+    //   a full window the one leaving still takes up a slot until it's gone
+    stats_extreme_expire(&stats->min, stats->seq + 1 - stats->count);
+    stats_extreme_expire(&stats->max, stats->seq + 1 - stats->count);
+    stats_extreme_push(&stats->min, stats->seq, value, true);
+    stats_extreme_push(&stats->max, stats->seq, value, false);
+    stats->seq++;
+}
+
+/*! Returns the number of samples currently in the window.
+ */
+uint16_t stats_count(const stats_t * stats)
+{
+    return stats->count;
+}
+
+/*! Returns true once the window has been filled up.
+ */
+bool stats_full(const stats_t * stats)
+{
+    return stats->count == stats->window;
+}
+
+/*! Returns the most recent sample. Zero if there isn't one.
+ */
+int32_t stats_latest(const stats_t * stats)
+{
+    if (stats->count == 0) {
+        return 0;
+    }
+    return stats->samples[stats->head == 0 ? stats->window - 1 : stats->head - 1];
+}
+
+/*! Returns the mean of the window, rounded toward zero. Zero if it's empty.
+ */
+int32_t stats_mean(const stats_t * stats)
+{
+    if (stats->count == 0) {
+        return 0;
+    }
+    return (int32_t)(stats->sum / stats->count);
+}
+
+/*! Returns the (population) variance of the window, in units squared.
+ *   n * sum(x^2) - sum(x)^2, over n^2.
+ */
+uint32_t stats_variance(const stats_t * stats)
+{
+    int64_t n = stats->count;
+    int64_t num;
+
+    if (n < 2) {
+        return 0;
+    }
+    num = n * stats->sum_sq - stats->sum * stats->sum;
+    if (num <= 0) {
+        return 0;
+    }
+    num /= n * n;
+    return num > UINT32_MAX ? UINT32_MAX : (uint32_t)num;
+}
+
+/*! Returns the smallest sample in the window. Zero if it's empty.
+ */
+int32_t stats_min(const stats_t * stats)
+{
+    if (stats->min.len == 0) {
+        return 0;
+    }
+    return stats->min.entries[stats->min.head].value;
+}
+
+/*! Returns the largest sample in the window. Zero if it's empty.
+ */
+int32_t stats_max(const stats_t * stats)
+{
+    if (stats->max.len == 0) {
+        return 0;
+    }
+    return stats->max.entries[stats->max.head].value;
+}
+
+
+/*! Private function that adds a sample to the back of a min / max queue. Every
+ *   entry it beats can never be the extreme again, so they're popped off first.
+ *   Each sample is pushed and popped at most once, hence amortized O(1).
+ */
+static void stats_extreme_push(stats_extreme_t * q, uint32_t seq, int32_t value, bool is_min)
+{
+    while (q->len > 0) {
+        uint16_t tail = (q->head + q->len - 1) % STATS_MAX_WINDOW;
+        int32_t tail_value = q->entries[tail].value;
+        if ((is_min && tail_value < value) || (!is_min && tail_value > value)) {
+            break;
+        }
+        q->len--;
+    }
+    uint16_t idx = (q->head + q->len) % STATS_MAX_WINDOW;
+    q->entries[idx].seq = seq;
+    q->entries[idx].value = value;
+    q->len++;
+}
+
+/*! Private function that pops entries that have slid out of the window off
+ *   the front of a min / max queue.
+ */
+static void stats_extreme_expire(stats_extreme_t * q, uint32_t oldest_seq)
+{
+    while (q->len > 0 && (int32_t)(q->entries[q->head].seq - oldest_seq) < 0) {
+        q->head = (q->head + 1) % STATS_MAX_WINDOW;
+        q->len--;
+    }
+}
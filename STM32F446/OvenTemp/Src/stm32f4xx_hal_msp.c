@@ -9,6 +9,8 @@
  */
 
 #include "stm32f4xx_hal.h"
+#include "common.h"
+#include "hardware.h"
 
 // Extern variables and functions
 extern DMA_HandleTypeDef hdma_adc1;
@@ -47,10 +49,37 @@ void HAL_ADC_MspInit(ADC_HandleTypeDef* hadc)
         /* Peripheral clock enable */
         __HAL_RCC_ADC1_CLK_ENABLE();
 
+        /* ADC1 DMA Init. One scan, or a block of timer triggered scans, per transfer.
+           In simultaneous mode it moves ADC1 and ADC2's results together as one word. */
+        hdma_adc1.Instance = DMA2_Stream0;
+        hdma_adc1.Init.Channel = DMA_CHANNEL_0;
+        hdma_adc1.Init.Direction = DMA_PERIPH_TO_MEMORY;
+        hdma_adc1.Init.PeriphInc = DMA_PINC_DISABLE;
+        hdma_adc1.Init.MemInc = DMA_MINC_ENABLE;
+#if ADC_SIMULTANEOUS
+        hdma_adc1.Init.PeriphDataAlignment = DMA_PDATAALIGN_WORD;
+        hdma_adc1.Init.MemDataAlignment = DMA_MDATAALIGN_WORD;
+#else
+        hdma_adc1.Init.PeriphDataAlignment = DMA_PDATAALIGN_HALFWORD;
+        hdma_adc1.Init.MemDataAlignment = DMA_MDATAALIGN_HALFWORD;
+#endif
+        hdma_adc1.Init.Mode = DMA_CIRCULAR;  // ADC DDS bit decides if it keeps going
+        hdma_adc1.Init.Priority = DMA_PRIORITY_LOW;
+        hdma_adc1.Init.FIFOMode = DMA_FIFOMODE_DISABLE;
+        if (HAL_DMA_Init(&hdma_adc1) != HAL_OK) {
+            Error_Handler();
+        }
+        __HAL_LINKDMA(hadc, DMA_Handle, hdma_adc1);
+
         /* ADC1 interrupt Init */
         HAL_NVIC_SetPriority(ADC_IRQn, 0, 0);
         HAL_NVIC_EnableIRQ(ADC_IRQn);
     }
+    else if(hadc->Instance == ADC2)
+    {
+        /* Peripheral clock enable. Its data goes out through ADC1's DMA. */
+        __HAL_RCC_ADC2_CLK_ENABLE();
+    }
 }
 
 
@@ -69,9 +98,39 @@ void HAL_ADC_MspDeInit(ADC_HandleTypeDef* hadc)
         */
         HAL_GPIO_DeInit(GPIOA, GPIO_PIN_4 | GPIO_PIN_6);
 
+        /* ADC1 DMA DeInit */
+        HAL_DMA_DeInit(hadc->DMA_Handle);
+
         /* ADC1 interrupt DeInit */
         HAL_NVIC_DisableIRQ(ADC_IRQn);
     }
+    else if(hadc->Instance == ADC2)
+    {
+        /* Peripheral clock disable */
+        __HAL_RCC_ADC2_CLK_DISABLE();
+    }
+}
+
+
+/******** TIM FUNCTIONS ***********/
+
+
+void HAL_TIM_Base_MspInit(TIM_HandleTypeDef* htim)
+{
+    if(htim->Instance == TIM2)
+    {
+        /* Peripheral clock enable */
+        __HAL_RCC_TIM2_CLK_ENABLE();
+    }
+}
+
+void HAL_TIM_Base_MspDeInit(TIM_HandleTypeDef* htim)
+{
+    if(htim->Instance == TIM2)
+    {
+        /* Peripheral clock disable */
+        __HAL_RCC_TIM2_CLK_DISABLE();
+    }
 }
 
 
@@ -0,0 +1,99 @@
+/*!
+ * @file    tables.c
+ * @author  Tyler Holmes
+ * @date    16-Oct-2026
+ * @brief   Constant tables generated from the calibration description.
+ *
+ *      Generated by scripts/gen_tables.py from scripts/calibration.json. Don't edit,
+ *      change the description and run `make tables` instead.
+ */
+
+#include <stdint.h>
+
+#include "tables.h"
+
+
+/*! Temperature, in centi-degrees, at each vout / vref of
+ *   `THERM_LUT_RATIO_START` + (i << `THERM_LUT_SEGMENT_SHIFT`) (q16). The
+ *   type K curve through a 122.4x amp with 5 mV/C cold junction
+ *   compensation, the cold junction at 25 C.
+ */
+const int32_t therm_ratio_lut[THERM_LUT_SIZE] = {
+    -2528, -1691, -867, -53, 752, 1551, 2342, 3128,
+    3909, 4686, 5460, 6231, 7000, 7768, 8537, 9306,
+    10076, 10849, 11625, 12404, 13187, 13973, 14762, 15555,
+    16351, 17149, 17948, 18747, 19547, 20345, 21143, 21938,
+    22731, 23521, 24308, 25093, 25876, 26656, 27433, 28208,
+    28982, 29753, 30523, 31291, 32058, 32823, 33587, 34350,
+    35112, 35873, 36633, 37392, 38150, 38907, 39664, 40419,
+    41174,
+};
+
+/*! Added to the q16 vout / vref ratio to correct for the cold junction
+ *   being at `THERM_CJC_START_CC` + i * `THERM_CJC_STEP_CC` instead of
+ *   `THERM_COLD_JUNCTION_CC`: the type K curve's rise over that, less
+ *   the amp's 5 mV/C of its own compensation.
+ */
+const int32_t therm_cjc_ratio[THERM_CJC_SIZE] = {
+    135, 60, 14, -8, -8, 10, 42, 82,
+    126,
+};
+
+/*! Default smoothing for continuous readings: order 2 Butterworth low pass
+ *   with its corner at 0.02 of the decimated sample rate. CMSIS order
+ *   (b0, b1, b2, -a1, -a2) per stage, q31 shifted down by
+ *   `THERM_SMOOTHING_SHIFT` to fit a1. Each b1 is trimmed for exactly unity
+ *   DC gain.
+ */
+const int32_t therm_smoothing_filter[THERM_SMOOTHING_STAGES * 5] = {
+    3888751, 7777501, 3888751, 1957103774, -898916953,
+};
+
+//! Boxcar taps for the mains decimator
+const int32_t therm_mains_taps[THERM_MAINS_SAMPLES_PER_CYCLE] = {
+    268435456, 268435456, 268435456, 268435456, 268435456, 268435456, 268435456, 268435456,
+};
+
+//! Goertzel 2cos(w) per bin, `CYCLE_MIN_BIN` first
+const float cycle_goertzel_coeffs[CYCLE_BINS] = {
+    1.990369453e+00f, 1.978353020e+00f, 1.961570561e+00f, 1.940062506e+00f,
+    1.913880671e+00f, 1.883088130e+00f, 1.847759065e+00f, 1.807978586e+00f,
+    1.763842529e+00f, 1.715457220e+00f, 1.662939225e+00f, 1.606415063e+00f,
+    1.546020907e+00f, 1.481902251e+00f, 1.414213562e+00f,
+};
+
+//! Hann window over a Goertzel block
+const float cycle_hann_window[CYCLE_BLOCK] = {
+    0.000000000e+00f, 6.022718974e-04f, 2.407636664e-03f, 5.411745018e-03f,
+    9.607359798e-03f, 1.498437340e-02f, 2.152983213e-02f, 2.922796741e-02f,
+    3.806023374e-02f, 4.800535344e-02f, 5.903936783e-02f, 7.113569500e-02f,
+    8.426519385e-02f, 9.839623426e-02f, 1.134947733e-01f, 1.295244373e-01f,
+    1.464466094e-01f, 1.642205226e-01f, 1.828033579e-01f, 2.021503478e-01f,
+    2.222148835e-01f, 2.429486279e-01f, 2.643016316e-01f, 2.862224533e-01f,
+    3.086582838e-01f, 3.315550733e-01f, 3.548576614e-01f, 3.785099100e-01f,
+    4.024548390e-01f, 4.266347628e-01f, 4.509914298e-01f, 4.754661628e-01f,
+    5.000000000e-01f, 5.245338372e-01f, 5.490085702e-01f, 5.733652372e-01f,
+    5.975451610e-01f, 6.214900900e-01f, 6.451423386e-01f, 6.684449267e-01f,
+    6.913417162e-01f, 7.137775467e-01f, 7.356983684e-01f, 7.570513721e-01f,
+    7.777851165e-01f, 7.978496522e-01f, 8.171966421e-01f, 8.357794774e-01f,
+    8.535533906e-01f, 8.704755627e-01f, 8.865052267e-01f, 9.016037657e-01f,
+    9.157348062e-01f, 9.288643050e-01f, 9.409606322e-01f, 9.519946466e-01f,
+    9.619397663e-01f, 9.707720326e-01f, 9.784701679e-01f, 9.850156266e-01f,
+    9.903926402e-01f, 9.945882550e-01f, 9.975923633e-01f, 9.993977281e-01f,
+    1.000000000e+00f, 9.993977281e-01f, 9.975923633e-01f, 9.945882550e-01f,
+    9.903926402e-01f, 9.850156266e-01f, 9.784701679e-01f, 9.707720326e-01f,
+    9.619397663e-01f, 9.519946466e-01f, 9.409606322e-01f, 9.288643050e-01f,
+    9.157348062e-01f, 9.016037657e-01f, 8.865052267e-01f, 8.704755627e-01f,
+    8.535533906e-01f, 8.357794774e-01f, 8.171966421e-01f, 7.978496522e-01f,
+    7.777851165e-01f, 7.570513721e-01f, 7.356983684e-01f, 7.137775467e-01f,
+    6.913417162e-01f, 6.684449267e-01f, 6.451423386e-01f, 6.214900900e-01f,
+    5.975451610e-01f, 5.733652372e-01f, 5.490085702e-01f, 5.245338372e-01f,
+    5.000000000e-01f, 4.754661628e-01f, 4.509914298e-01f, 4.266347628e-01f,
+    4.024548390e-01f, 3.785099100e-01f, 3.548576614e-01f, 3.315550733e-01f,
+    3.086582838e-01f, 2.862224533e-01f, 2.643016316e-01f, 2.429486279e-01f,
+    2.222148835e-01f, 2.021503478e-01f, 1.828033579e-01f, 1.642205226e-01f,
+    1.464466094e-01f, 1.295244373e-01f, 1.134947733e-01f, 9.839623426e-02f,
+    8.426519385e-02f, 7.113569500e-02f, 5.903936783e-02f, 4.800535344e-02f,
+    3.806023374e-02f, 2.922796741e-02f, 2.152983213e-02f, 1.498437340e-02f,
+    9.607359798e-03f, 5.411745018e-03f, 2.407636664e-03f, 6.022718974e-04f,
+};
@@ -9,195 +9,1049 @@
 #include <stdint.h>
 
 #include "common.h"
+#include "filter.h"
 #include "hardware.h"
+#include "median.h"
+#include "sample_queue.h"
+#include "stats.h"
+#include "tables.h"
+#include "thermocouple.h"
+#include "tracker.h"
 #include "stm32f4xx_hal.h"
 #include "stm32f4xx_hal_adc.h"
-// #include "stm32f4xx_hal_dma.h"
+#include "stm32f4xx_hal_dma.h"
 
 
-#define NUM_READINGS  (8)  // TODO: justify
-#define THERM_GET_IDEX()   (reading_index == (NUM_READINGS - 1) ? 0 : reading_index)
+//! Default number of readings `therm_getValue_averaged_cC` averages over
+#define THERM_DEFAULT_WINDOW  (8)
+
+//! Most scans a single DMA block (half of the ping-pong buffer) can hold
+#define THERM_MAX_BLOCK_SCANS      (256)
+//! Default sample clock for continuous readings, in Hz
+#define THERM_DEFAULT_SAMPLE_RATE  (1000)
+//! Default number of decimated samples averaged into each continuous reading
+#define THERM_DEFAULT_BLOCK_SIZE   (32)
+#if THERM_DEFAULT_BLOCK_SIZE > SAMPLEQ_LEN
+#error "A continuous block has to fit in the sample queue"
+#endif
+//! Scan clock used to take the oversampling burst of a single reading, in Hz.
+//!   Each rank takes 112 + 12 ADC clocks = 15.5us. Simultaneous scans are 2
+//!   ranks with the die temperature (31us), so this leaves some slack.
+#define THERM_BURST_RATE_HZ        (20000)
+//! Bits of every decimated sample, regardless of how much we oversample.
+#define THERM_SAMPLE_BITS          (12 + THERM_MAX_OVERSAMPLE_BITS)
+
+#define THERM_BURST_SCANS(n)       (1UL << (2 * (n)))  //!< 4^n scans per decimated sample
+//! Scan rate continuous readings locked to `hz` mains run at with `n` extra bits.
+//!   Has to stay within `THERM_BURST_RATE_HZ`, or the scans overrun each other.
+#define THERM_MAINS_RATE_HZ(hz, n) ((uint32_t)(hz) * THERM_MAINS_SAMPLES_PER_CYCLE * THERM_BURST_SCANS(n))
+
+//! Longest a watchdog scan can take, in ms. It really takes ~31us.
+#define THERM_WATCHDOG_TIMEOUT_MS  (2)
+
+#if ADC_SCAN_DIE_TEMP
+//! Factory calibration of the die temperature sensor: raw 12 bit counts at
+//!   30 C and 110 C, with VDDA at 3.3 V
+#define THERM_TS_CAL1  (*(const uint16_t *)0x1FFF7A2CUL)
+#define THERM_TS_CAL2  (*(const uint16_t *)0x1FFF7A2EUL)
+#endif
+//! Each sample moves the cold junction estimate 1 / 2^n of the way. The die
+//!   sensor is noisy and the board warms up slowly.
+#define THERM_CJC_SMOOTHING_SHIFT  (6)
+
+//! Calibration gains outside 1/2 to 2 can only be a bad capture, not the amp
+#define THERM_CAL_MIN_GAIN  (1L << (THERM_CAL_GAIN_SHIFT - 1))
+#define THERM_CAL_MAX_GAIN  (1L << (THERM_CAL_GAIN_SHIFT + 1))
+//! Same for offsets past ~60 C worth of ratio
+#define THERM_CAL_MAX_OFFSET  (1L << 14)
+//! Closest two calibration points can be, in q16 ratio (~30 C), for a usable gain
+#define THERM_CAL_MIN_SPAN  (1L << 13)
+
+//! Default spike rejection: outliers are 3 sigma off the median of the last 9
+#define THERM_DEFAULT_DESPIKE_WINDOW     (9)
+#define THERM_DEFAULT_DESPIKE_THRESHOLD  (30)
+//! Samples within this many cC of the median are never spikes. A few ADC counts.
+#define THERM_DESPIKE_MIN_DEVIATION      (50)
+/*! Readings of the same kind closer together than this share a spike window.
+ *   Further apart, a moving oven would have drifted off the old median. The
+ *   HAL tick stops in STOP, so idle samples a minute apart still share one.
+ */
+#define THERM_DESPIKE_MAX_GAP_MS         (2000)
+
+//! Most samples `therm_process` pulls off the queue (and filters) at once
+#define THERM_PROCESS_BATCH  (16)
+
+//! How fast the oven's rate of rise can change, (cC / s)^2 per second. Roughly
+//!   +/- 1 C/s of slope change over 10 seconds, like the element cycling.
+#define THERM_TRACKER_PROCESS_VAR  (1000.0f)
+//! Variance of a single reading, in cC^2. A couple of counts of ADC noise.
+#define THERM_SINGLE_READING_VAR   (1024.0f)
+//! Smallest variance we'll claim for a reading, in cC^2. Resolution of the ADC.
+#define THERM_MIN_READING_VAR      (16.0f)
+
+//! Decimated samples per DMA block while taking an adaptive reading. Small, so
+//!   we get to check the noise often, but big enough to not wake up per sample.
+#define THERM_ADAPTIVE_BLOCK_SIZE  (4)
+//! Default target standard error of an adaptive reading, in centi-degrees
+#define THERM_DEFAULT_TARGET_SE    (5)
+#define THERM_DEFAULT_MIN_CONVERSIONS  (4)
+#define THERM_DEFAULT_MAX_CONVERSIONS  (STATS_MAX_WINDOW)
+
+//! The different ways a reading can be taken.
+typedef enum {
+    kThermReading_Single,      //!< one sample (one scan, or one oversampled burst)
+    kThermReading_Continuous,  //!< timer paced samples until told to stop
+    kThermReading_Adaptive,    //!< timer paced samples until the mean is good enough
+} therm_reading_t;
 
   //! HAL ADC handle to get readings
 extern ADC_HandleTypeDef hadc1;
+#if ADC_SIMULTANEOUS
+extern ADC_HandleTypeDef hadc2;
+#endif
+
+//! Window of readings, in centi-degrees celsius, for averaging and noise estimates
+static stats_t readings;
+//! Hampel filter every sample goes through first, to knock out pickup spikes
+static median_t despike;
+//! Boxcar decimator that notches out mains hum from continuous readings
+static filter_decim_t mains_notch;
+static uint8_t mains_hz = THERM_MAINS_HZ;  //!< mains frequency to reject, 0 for none
+//! IIR stage continuous readings go through on their way into `readings`
+static filter_t smoothing;
+//! Temperature and slope estimate, updated by each single or adaptive reading
+static tracker_t trend;
+
+/*! Where the DMA stores scans of all ADC channels (in `ADC_SCAN_` order, repeating).
+ *   Continuous readings use it as two blocks: we decimate one while the DMA
+ *   fills the other. Word aligned, since with `ADC_SIMULTANEOUS` the DMA moves
+ *   words into it and needs the address aligned to match.
+ */
+static uint16_t pending_readings[2 * THERM_MAX_BLOCK_SCANS * NUM_ADC_CHANNELS]
+    __attribute__((aligned(4)));
+//! Decimated samples on their way from the ADC interrupt to the main loop
+static sampleq_t sample_queue;
+static uint32_t sample_seq;  //!< sequence number of the next sample. ISR only
 
-static float vout_readings[NUM_READINGS];  //!< circular buffer of readings for averaging
-static float vref_readings[NUM_READINGS];  //!< circular buffer of readings for averaging
+// Shared with the ADC interrupt
+static volatile bool keep_converting;  //!< tracks if we should continue triggering ADC conversions
+static volatile bool ADC_running;      //!< True if we are currently running the ADC peripheral
+static volatile uint16_t running_block;  //!< decimated samples per DMA block of the running reading
 
-//! Where the ADC stores the current reading, via either DMA or interrupt
-static uint32_t pending_readings[3];
-//! The current, most valid index from the ADC stored in `vout_readings` or `vref_readings`
-static uint8_t reading_index;
-static bool keep_converting;  //!< tracks if we should continue triggering ADC conversions
+// Main loop only
 static bool reading_ready;    //!< True if there is a valid reading available
-static bool ADC_running;      //!< True if we are currently running the ADC peripheral
+static uint32_t last_seq;     //!< sequence number of the last sample we processed
+static uint32_t missed_samples;  //!< samples the queue dropped or we never saw
+static int32_t wake_threshold;     //!< analog watchdog threshold, in centi-degrees celsius
+static uint16_t last_vref_counts;  //!< raw vref from the last watchdog scan
+static int32_t cold_junction;      //!< cold junction temperature, centi-degrees << `THERM_CJC_SMOOTHING_SHIFT`
+static bool cold_junction_valid;   //!< false until a sample has set `cold_junction`
+static int32_t cjc_ratio;          //!< q16 ratio correction for the cold junction
+static int32_t cal_gain = 1L << THERM_CAL_GAIN_SHIFT;  //!< this unit's gain correction
+static int32_t cal_offset;         //!< and offset, q16 ratio
+
+static bool powered;                  //!< True if the ADC and analog front end are on
+static uint32_t power_tick;           //!< HAL tick they were powered up at
+static bool start_pending;            //!< True if a reading is waiting for the front end to settle
+static therm_reading_t pending_type;  //!< the reading that's waiting
+
+static therm_reading_t reading_type;  //!< what kind of reading was started last
+static therm_reading_t despike_type;  //!< kind of reading the spike window's samples are from
+static uint32_t despike_tick;         //!< HAL tick of the newest sample in the spike window
+static uint32_t despike_base;         //!< spikes rejected before the current reading started
+static stats_t adaptive;              //!< samples of the adaptive reading in progress
+static uint32_t adaptive_target_var;  //!< target standard error, squared
+static uint16_t adaptive_min;         //!< fewest conversions an adaptive reading takes
+static uint16_t last_conversions;     //!< conversions the last adaptive reading took
+static uint32_t total_conversions;    //!< conversions all adaptive readings took
+
+static uint32_t sample_rate_hz = THERM_DEFAULT_SAMPLE_RATE;  //!< continuous sample clock
+static uint16_t block_size = THERM_DEFAULT_BLOCK_SIZE;  //!< decimated samples per continuous reading
+static uint8_t oversample_bits = 0;  //!< extra bits of resolution. 4^n scans per sample
 
 
 // Private function definitions
-static void therm_ADC_done(void);
-static void therm_startReading(bool single);
+static void therm_ADC_done(const uint16_t * scans, uint16_t num_samples);
+static int32_t therm_countsToCentiC(uint32_t vout, uint32_t vref);
+static uint32_t therm_centiCToRatio(int32_t temp);
+static int32_t therm_uncalibrate(int32_t ratio);
+static void therm_coldJunction(uint16_t die, uint16_t vref);
+static uint16_t therm_decimate(const uint16_t * scans, uint8_t channel);
+static void therm_startReading(therm_reading_t type);
+static void therm_discardQueued(void);
 
-/*! Initializes all private variables for the thermocouple module to work.
- *    Does NOT start an ADC reading.
+/*! Initializes all private variables for the thermocouple module to work and
+ *    powers up the ADC and analog front end. Does NOT start an ADC reading.
  */
 void therm_init(void)
 {
-    for (int8_t i = NUM_READINGS - 1; i > 0; i--) {
-        vout_readings[i] = 0;
-        vref_readings[i] = 0;
+    stats_init(&readings, THERM_DEFAULT_WINDOW);
+    median_init(&despike, THERM_DEFAULT_DESPIKE_WINDOW, THERM_DEFAULT_DESPIKE_THRESHOLD,
+                THERM_DESPIKE_MIN_DEVIATION);
+    despike_base = 0;
+    // Generated low pass, corner at 1/50th of the decimated sample rate: 1.2 Hz
+    //   once the mains rejection has brought it down to 60 Hz
+    filter_init(&smoothing, therm_smoothing_filter, THERM_SMOOTHING_STAGES,
+                THERM_SMOOTHING_SHIFT);
+    tracker_init(&trend, THERM_TRACKER_PROCESS_VAR);
+    therm_setMains(THERM_MAINS_HZ);
+    sampleq_init(&sample_queue);
+    sample_seq = 0;
+    last_seq = UINT32_MAX;
+    missed_samples = 0;
+    wake_threshold = 0;
+    last_vref_counts = THERM_NOMINAL_VREF_COUNTS;
+    cold_junction = 0;
+    cold_junction_valid = false;
+    cjc_ratio = 0;
+    for (uint16_t i = 0; i < 2 * THERM_MAX_BLOCK_SCANS * NUM_ADC_CHANNELS; i++) {
+        pending_readings[i] = 0;
     }
-    pending_readings[0] = 0;
-    pending_readings[1] = 0;
-    pending_readings[2] = 0;
-    reading_index = 0;
+    keep_converting = false;
     reading_ready = false;
     ADC_running = false;
+    reading_type = kThermReading_Single;
+    therm_configureAdaptive(THERM_DEFAULT_TARGET_SE, THERM_DEFAULT_MIN_CONVERSIONS,
+                            THERM_DEFAULT_MAX_CONVERSIONS);
+    last_conversions = 0;
+    total_conversions = 0;
+    start_pending = false;
+    powered = false;
+    therm_powerUp();
 }
 
-/*! Private function that either kicks off a single ADC reading or continuous
- *    readings. Called by the public functions `therm_startReading_single` and
- *    `therm_startReading_continuous`.
+/*! Sets how many readings `therm_getValue_averaged_cC` and the statistics
+ *   functions look back over, up to `STATS_MAX_WINDOW`. Drops every reading
+ *   taken so far.
  */
-static void therm_startReading(bool single_reading)
+ret_t therm_setWindow(uint16_t num_readings)
 {
-    // Start an ADC conversions for both channels
-    if (HAL_ADC_Start_IT(&hadc1) != HAL_OK) {
-        Error_Handler();
+    return stats_init(&readings, num_readings);
+}
+
+/*! Sets up the sample clock and block size used by continuous readings. Scans
+ *   are taken `rate_hz` times a second, decimated by the current oversampling
+ *   ratio, and every `size` decimated samples are averaged into one reading.
+ *   A block is queued all at once from the DMA interrupt, so `size` can't be
+ *   more than `SAMPLEQ_LEN` (or it could never be taken without drops).
+ *   Can't be changed while continuous readings are running.
+ */
+ret_t therm_configureContinuous(uint32_t rate_hz, uint16_t size)
+{
+    if (keep_converting) {
+        return RET_BUSY_ERR;
     }
-    if (single_reading) {
-        reading_ready = false;
+    if (rate_hz == 0 || rate_hz > TIM2_TICK_HZ || size == 0 || size > SAMPLEQ_LEN ||
+        size * THERM_BURST_SCANS(oversample_bits) > THERM_MAX_BLOCK_SCANS) {
+        return RET_INVALID_ARGS_ERR;
+    }
+    sample_rate_hz = rate_hz;
+    block_size = size;
+    return RET_OK;
+}
+
+/*! Sets how many extra bits of resolution we get by oversampling. Every sample
+ *   is built from a burst of 4^`extra_bits` scans that are summed up as integers
+ *   and decimated, which gains one real bit per factor of 4 (the ADC noise acts
+ *   as dither). Costs conversion time, not wakeups: the whole burst is paced by
+ *   TIM2 and lands in one DMA transfer. Shrinks the continuous block size if it
+ *   no longer fits. Locked to the mains, the scan rate goes up with it too, so
+ *   anything past 2 extra bits there is rejected (see `therm_setMains`). Can't
+ *   be changed while a reading is running, a single burst included: the DMA
+ *   interrupt decimates with it and uses it to decide whether to stop TIM2.
+ */
+ret_t therm_setOversampling(uint8_t extra_bits)
+{
+    if (ADC_running || keep_converting) {
+        return RET_BUSY_ERR;
+    }
+    if (extra_bits > THERM_MAX_OVERSAMPLE_BITS ||
+        THERM_MAINS_RATE_HZ(mains_hz, extra_bits) > THERM_BURST_RATE_HZ) {
+        return RET_INVALID_ARGS_ERR;
+    }
+    oversample_bits = extra_bits;
+    if (block_size * THERM_BURST_SCANS(extra_bits) > THERM_MAX_BLOCK_SCANS) {
+        // Shrink the continuous block so it still fits in the DMA buffer. Only
+        //   ever shrinks, so it stays within the sample queue too.
+        block_size = THERM_MAX_BLOCK_SCANS / THERM_BURST_SCANS(extra_bits);
+    }
+    return RET_OK;
+}
+
+/*! Sets the mains frequency (50 or 60 Hz) continuous readings reject, or 0 to
+ *   not bother. With it set, continuous readings ignore the rate from
+ *   `therm_configureContinuous` and sample at exactly
+ *   `THERM_MAINS_SAMPLES_PER_CYCLE` times the mains frequency. Each cycle's
+ *   worth is averaged down to one sample, which nulls the hum and all of its
+ *   harmonics, instead of having to average it away over hundreds of samples.
+ *   How deep the notch is comes down to how close the sample clock is, and
+ *   the HSI is only good to ~1%. Rejected if that, times the oversampling, is
+ *   faster than the ADC can scan. Can't be changed while continuous readings
+ *   are running.
+ */
+ret_t therm_setMains(uint8_t hz)
+{
+    if (keep_converting) {
+        return RET_BUSY_ERR;
+    }
+    if ((hz != 0 && hz != 50 && hz != 60) ||
+        THERM_MAINS_RATE_HZ(hz, oversample_bits) > THERM_BURST_RATE_HZ) {
+        return RET_INVALID_ARGS_ERR;
     }
-    if (keep_converting != !single_reading) {
-        // This is our first time getting called for continuous readings. reset
-        //   the `reading_index` to make sure we get all new values when averaging.
-        reading_index = 0;
-        keep_converting = true;
+    mains_hz = hz;
+    return filter_decimInit(&mains_notch, therm_mains_taps,
+                            hz != 0 ? THERM_MAINS_SAMPLES_PER_CYCLE : 0);
+}
+
+/*! Sets up the spike rejection every sample goes through before anything else.
+ *   A sample more than `threshold_tenths` / 10 standard deviations from the
+ *   median of the last `window` samples is swapped for that median. A window
+ *   of 0 turns it off. Can't be changed while a reading is running.
+ */
+ret_t therm_setDespike(uint16_t window, uint16_t threshold_tenths)
+{
+    if (ADC_running) {
+        return RET_BUSY_ERR;
+    }
+    despike_base = 0;
+    return median_init(&despike, window, threshold_tenths, THERM_DESPIKE_MIN_DEVIATION);
+}
+
+/*! Sets the IIR filter continuous readings are run through before they go
+ *   into the window: `num_stages` biquads, with `FILTER_COEFFS_PER_STAGE` q31
+ *   coefficients each in CMSIS order (b0, b1, b2, -a1, -a2), all scaled down
+ *   by 2^`post_shift`. Each stage needs unity DC gain. `num_stages` of 0 turns
+ *   the filter off. Can't be changed while continuous readings are running.
+ */
+ret_t therm_setFilter(const int32_t * coeffs, uint8_t num_stages, uint8_t post_shift)
+{
+    if (ADC_running && keep_converting) {
+        return RET_BUSY_ERR;
+    }
+    return filter_init(&smoothing, coeffs, num_stages, post_shift);
+}
+
+/*! Sets this unit's calibration, as solved by `therm_solveCalibration`: every
+ *   q16 vout / vref ratio becomes ratio * `gain` / 2^`THERM_CAL_GAIN_SHIFT` +
+ *   `offset` before it's converted. Survives `therm_init`. Returns RET_CAL_ERR
+ *   (and leaves the old one) if it's too far off to be real.
+ */
+ret_t therm_setCalibration(int32_t gain, int32_t offset)
+{
+    if (gain < THERM_CAL_MIN_GAIN || gain > THERM_CAL_MAX_GAIN ||
+        offset < -THERM_CAL_MAX_OFFSET || offset > THERM_CAL_MAX_OFFSET) {
+        return RET_CAL_ERR;
+    }
+    cal_gain = gain;
+    cal_offset = offset;
+    return RET_OK;
+}
+
+/*! Sets up adaptive readings. Samples are taken until the standard error of
+ *   their mean, sqrt(s^2 / n) with s^2 the (unbiased, n - 1) sample variance,
+ *   drops below `target_se` centi-degrees, but never fewer than
+ *   `min_conversions` or more than `max_conversions` (which is capped by
+ *   `STATS_MAX_WINDOW`). Can't be changed while a reading is running.
+ */
+ret_t therm_configureAdaptive(uint32_t target_se, uint16_t min_conversions, uint16_t max_conversions)
+{
+    ret_t ret;
+
+    if (ADC_running) {
+        return RET_BUSY_ERR;
+    }
+    if (min_conversions < 2 || min_conversions > max_conversions || target_se > UINT16_MAX) {
+        return RET_INVALID_ARGS_ERR;
+    }
+    ret = stats_init(&adaptive, max_conversions);
+    if (ret != RET_OK) {
+        return ret;
+    }
+    adaptive_target_var = target_se * target_se;
+    adaptive_min = min_conversions;
+    return RET_OK;
+}
+
+/*! Private function that kicks off a reading of the given type. Called by the
+ *    public `therm_startReading_*` functions.
+ */
+static void therm_startReading(therm_reading_t type)
+{
+    HAL_StatusTypeDef ret;
+    uint32_t num_scans;
+    uint32_t rate_hz;
+
+    if (!therm_settled()) {
+        // Don't sit here waiting on the front end. `therm_process` starts the
+        //   reading once it has settled, and `therm_ADCRunning` says we're busy
+        //   until then, so the main loop can sleep through it.
+        therm_powerUp();
+        reading_ready = false;
+        pending_type = type;
+        start_pending = true;
+        return;
     }
+    start_pending = false;
+
+    // Anything still queued up belongs to the previous reading
+    therm_process();
+    reading_ready = false;
+    reading_type = type;
+    keep_converting = (type != kThermReading_Single);
     ADC_running = true;
+    // Spikes are judged against the samples before them, the last reading's
+    //   included, so even one sample readings get checked. That window is only
+    //   good for readings of the same kind that aren't far apart. Otherwise the
+    //   last one's median would have every sample of a moving oven thrown out.
+    if (type != despike_type || HAL_GetTick() - despike_tick > THERM_DESPIKE_MAX_GAP_MS) {
+        median_reset(&despike);
+        despike_type = type;
+    }
+    despike_base = median_rejected(&despike);
+
+    if (type == kThermReading_Single && oversample_bits == 0) {
+        // Scan both channels in one hardware sequence. The DMA moves each result
+        //   into `pending_readings` and we only get interrupted once it's all done.
+        hw_ADC1_setTrigger(kADCTrigger_Software);
+        num_scans = 1;
+        rate_hz = 0;
+    } else if (type == kThermReading_Single) {
+        // Oversampled: let TIM2 fire off the whole burst back to back and stop
+        //   everything once the DMA has all of it.
+        hw_ADC1_setTrigger(kADCTrigger_Timer);
+        num_scans = THERM_BURST_SCANS(oversample_bits);
+        rate_hz = THERM_BURST_RATE_HZ;
+    } else if (type == kThermReading_Adaptive) {
+        // Stream short blocks of samples as fast as we can burst them, and
+        //   let `therm_process` call it off once the mean is good enough.
+        hw_ADC1_setTrigger(kADCTrigger_Timer);
+        stats_reset(&adaptive);
+        running_block = THERM_ADAPTIVE_BLOCK_SIZE;
+        num_scans = 2 * running_block * THERM_BURST_SCANS(oversample_bits);
+        rate_hz = THERM_BURST_RATE_HZ;
+    } else {
+        // Let TIM2 pace the scans. The DMA wraps around both blocks of the
+        //   buffer on its own, so we're only woken up once per block of scans,
+        //   with a whole block of time to get through it. Clear out the window
+        //   to make sure we get all new values when averaging.
+        hw_ADC1_setTrigger(kADCTrigger_Timer);
+        stats_reset(&readings);
+        filter_decimReset(&mains_notch);
+        filter_reset(&smoothing);
+        running_block = block_size;
+        num_scans = 2 * running_block * THERM_BURST_SCANS(oversample_bits);
+        if (mains_hz != 0) {
+            // Lock the decimated sample rate to the mains
+            rate_hz = THERM_MAINS_RATE_HZ(mains_hz, oversample_bits);
+        } else {
+            rate_hz = sample_rate_hz;
+        }
+    }
+
+    ret = hw_ADC_startDMA(pending_readings, num_scans, keep_converting);
+    if (ret != HAL_OK) {
+        Error_Handler_withRetval(ret);
+    }
+    if (rate_hz != 0 && hw_TIM2_start(rate_hz) != RET_OK) {
+        Error_Handler();
+    }
 }
 
 /*! starts a single ADC reading.
  */
 void therm_startReading_single(void) {
-    therm_startReading(true);
+    therm_startReading(kThermReading_Single);
 }
 
-/*! starts continuous ADC readings.
+/*! starts continuous, timer paced ADC readings. See `therm_configureContinuous`.
  */
 void therm_startReading_continuous(void) {
-    therm_startReading(false);
+    therm_startReading(kThermReading_Continuous);
+}
+
+/*! starts an adaptive ADC reading, which keeps converting only until it's
+ *   precise enough. See `therm_configureAdaptive`. `therm_valueReady` goes true
+ *   once it's done, same as a single reading.
+ */
+void therm_startReading_adaptive(void) {
+    therm_startReading(kThermReading_Adaptive);
 }
 
-/*! Private function that gets called after the ADC is done converting all thermocouple
- *   values and pulls them from the `pending_readings` array. Also triggers another
- *   reading if the `keep_converting` flag is set.
+/*! Stops continuous ADC readings. The last readings stay available.
  */
-static void therm_ADC_done(void)
+void therm_stopReading(void)
 {
-    reading_index += 1;
-    if (reading_index >= NUM_READINGS) {
-        reading_index = 0;
+    hw_TIM2_stop();
+    hw_ADC_stopDMA();
+    keep_converting = false;
+    ADC_running = false;
+    start_pending = false;
+}
+
+/*! Powers up the ADC and the analog front end ahead of a reading. They need
+ *   `THERM_SETTLE_TIME_MS` before they read right (see `therm_settled`), so
+ *   the best time to call this is that long before the reading is due.
+ *   Does nothing if they're already on.
+ */
+void therm_powerUp(void)
+{
+    if (powered) {
+        return;
     }
-    vout_readings[reading_index] = (float)pending_readings[0];
-    vref_readings[reading_index] = (float)pending_readings[1];
-    if (keep_converting) {
-        // setup another round of readings
-        // BUG: I think we're starting it twice. Here and in the ISR.
-        therm_startReading_continuous();
-        if (!reading_ready && reading_index == 0) {
-            // We've had enough readings to get a valid, averaged temperature
-            reading_ready = true;
+    hw_ADC_setPower(true);
+    hw_AFE_setPower(true);
+    power_tick = HAL_GetTick();
+    powered = true;
+}
+
+/*! Powers down the ADC and the analog front end until the next reading.
+ *   Returns `RET_BUSY_ERR` if a reading is still running or waiting to start.
+ */
+ret_t therm_powerDown(void)
+{
+    if (ADC_running || start_pending) {
+        return RET_BUSY_ERR;
+    }
+    hw_AFE_setPower(false);
+    hw_ADC_setPower(false);
+    powered = false;
+    return RET_OK;
+}
+
+/*! Returns true if the ADC and analog front end are on and have had time to
+ *   settle. The tick only tells us a millisecond has started, so it takes one
+ *   more than `THERM_SETTLE_TIME_MS` to be sure.
+ */
+bool therm_settled(void)
+{
+    return powered && (HAL_GetTick() - power_tick) > THERM_SETTLE_TIME_MS;
+}
+
+/*! Sets the temperature, in centi-degrees celsius, that `therm_aboveThreshold_watchdog`
+ *   checks against.
+ */
+void therm_setWakeThreshold(int32_t threshold)
+{
+    wake_threshold = threshold;
+}
+
+/*! Checks if the thermocouple is above the wake threshold using the ADC's analog
+ *   watchdog instead of a full reading. The threshold is turned into raw vout
+ *   counts for the vref we saw last time (the conversion table, backwards), then
+ *   one plain 12 bit scan is done and the hardware compares it for us. Nothing
+ *   gets decimated, queued or converted to a temperature, and the scan only
+ *   takes ~31us, so it's polled instead of sleeping and waking back up for it.
+ *   Returns false if the ADC is busy with something else.
+ */
+bool therm_aboveThreshold_watchdog(void)
+{
+    uint32_t threshold_counts;
+    bool tripped = false;
+
+    if (ADC_running || !therm_settled()) {
+        return false;
+    }
+
+    threshold_counts = ((uint32_t)last_vref_counts *
+                        (uint32_t)therm_uncalibrate((int32_t)therm_centiCToRatio(wake_threshold) -
+                                                    cjc_ratio))
+                       >> THERM_RATIO_FRAC_BITS;
+    if (threshold_counts > 0xFFF) {
+        threshold_counts = 0xFFF;
+    }
+
+    hw_ADC1_setTrigger(kADCTrigger_Software);
+    hw_ADC1_setWatchdog(true, (uint16_t)threshold_counts);
+#if ADC_SIMULTANEOUS
+    __HAL_ADC_ENABLE(&hadc2);  // ADC1 starts it along with itself
+#endif
+    if (HAL_ADC_Start(&hadc1) == HAL_OK &&
+        HAL_ADC_PollForConversion(&hadc1, THERM_WATCHDOG_TIMEOUT_MS) == HAL_OK) {
+        tripped = __HAL_ADC_GET_FLAG(&hadc1, ADC_FLAG_AWD);
+        last_vref_counts = hw_ADC_getVref();
+    }
+    (void)HAL_ADC_Stop(&hadc1);
+#if ADC_SIMULTANEOUS
+    __HAL_ADC_DISABLE(&hadc2);
+#endif
+    hw_ADC1_setWatchdog(false, 0);
+    return tripped;
+}
+
+/*! Private function that turns a ratiometric pair of ADC counts into
+ *   centi-degrees celsius with the generated table, which follows the real
+ *   thermocouple and amp curve instead of a straight 5 mV/C. One divide for
+ *   the q16 ratio, one multiply-add for this unit's calibration, then the
+ *   segment is found with a shift and interpolated across, so it's constant
+ *   time and all integer. Past either end of the table the end segments carry on.
+ */
+static int32_t therm_countsToCentiC(uint32_t vout, uint32_t vref)
+{
+    int32_t ratio, offset, index, frac;
+
+    if (vref == 0) {
+        return 0;
+    }
+    ratio = (int32_t)((vout << THERM_RATIO_FRAC_BITS) / vref);
+    ratio = (int32_t)(((int64_t)ratio * cal_gain) >> THERM_CAL_GAIN_SHIFT) + cal_offset;
+    offset = ratio + cjc_ratio - (int32_t)THERM_LUT_RATIO_START;
+    index = offset >> THERM_LUT_SEGMENT_SHIFT;
+    if (index < 0) {
+        index = 0;
+    } else if (index > THERM_LUT_SIZE - 2) {
+        index = THERM_LUT_SIZE - 2;
+    }
+    frac = offset - (index << THERM_LUT_SEGMENT_SHIFT);
+    return therm_ratio_lut[index] +
+           (int32_t)(((int64_t)(therm_ratio_lut[index + 1] - therm_ratio_lut[index]) * frac)
+                     >> THERM_LUT_SEGMENT_SHIFT);
+}
+
+/*! Private function that goes the other way, from centi-degrees to the q16
+ *   vout / vref ratio, for setting up the watchdog. Binary searches the table,
+ *   which only happens once per idle wakeup.
+ */
+static uint32_t therm_centiCToRatio(int32_t temp)
+{
+    uint16_t lo = 0;
+    uint16_t hi = THERM_LUT_SIZE - 1;
+    int32_t ratio;
+
+    // Find the segment lo..lo + 1 that temp is in (or the one at the end)
+    while (hi - lo > 1) {
+        uint16_t mid = (lo + hi) / 2;
+
+        if (therm_ratio_lut[mid] <= temp) {
+            lo = mid;
+        } else {
+            hi = mid;
         }
+    }
+    ratio = (int32_t)THERM_LUT_RATIO_START + ((int32_t)lo << THERM_LUT_SEGMENT_SHIFT) +
+            (int32_t)(((int64_t)(temp - therm_ratio_lut[lo]) << THERM_LUT_SEGMENT_SHIFT) /
+                      (therm_ratio_lut[lo + 1] - therm_ratio_lut[lo]));
+    return ratio > 0 ? (uint32_t)ratio : 0;
+}
+
+/*! Private function that undoes this unit's calibration, from the ratio the
+ *   table wants back to the one the ADC sees. Has a divide, so it's only for
+ *   setting things up, not per sample.
+ */
+static int32_t therm_uncalibrate(int32_t ratio)
+{
+    int32_t raw = (int32_t)(((int64_t)(ratio - cal_offset) << THERM_CAL_GAIN_SHIFT) / cal_gain);
+
+    return raw > 0 ? raw : 0;
+}
+
+/*! Private function that updates the cold junction compensation from one
+ *   sample of the die temperature sensor. The sensor's counts are scaled to a
+ *   3.3 V VDDA using vref (same scan), so the factory calibration applies,
+ *   then smoothed, then the generated table gives the ratio correction for
+ *   it. Without `ADC_SCAN_DIE_TEMP` the table's own cold junction is assumed.
+ */
+static void therm_coldJunction(uint16_t die, uint16_t vref)
+{
+#if ADC_SCAN_DIE_TEMP
+    int32_t cal1 = (int32_t)THERM_TS_CAL1 << THERM_MAX_OVERSAMPLE_BITS;
+    int32_t cal2 = (int32_t)THERM_TS_CAL2 << THERM_MAX_OVERSAMPLE_BITS;
+    int32_t counts, temp, index, frac;
+
+    if (vref == 0 || cal2 <= cal1) {
+        return;
+    }
+    counts = (int32_t)(((uint32_t)die * (THERM_NOMINAL_VREF_COUNTS << THERM_MAX_OVERSAMPLE_BITS))
+                       / vref);
+    temp = 3000 + (counts - cal1) * 8000 / (cal2 - cal1);
+
+    if (!cold_junction_valid) {
+        cold_junction = temp << THERM_CJC_SMOOTHING_SHIFT;
+        cold_junction_valid = true;
     } else {
-        // Only one reading. Ready to read
-        reading_ready = true;
+        cold_junction += temp - (cold_junction >> THERM_CJC_SMOOTHING_SHIFT);
+    }
+    temp = cold_junction >> THERM_CJC_SMOOTHING_SHIFT;
+
+    // Same interpolation as the conversion, clamped at the ends
+    index = (temp - THERM_CJC_START_CC) / THERM_CJC_STEP_CC;
+    if (index < 0) {
+        cjc_ratio = therm_cjc_ratio[0];
+    } else if (index >= THERM_CJC_SIZE - 1) {
+        cjc_ratio = therm_cjc_ratio[THERM_CJC_SIZE - 1];
+    } else {
+        frac = temp - THERM_CJC_START_CC - index * THERM_CJC_STEP_CC;
+        cjc_ratio = therm_cjc_ratio[index] +
+                    (therm_cjc_ratio[index + 1] - therm_cjc_ratio[index]) * frac / THERM_CJC_STEP_CC;
+    }
+#else
+    (void)die;
+    (void)vref;
+#endif
+}
+
+/*! Private function that sums up one burst of 4^`oversample_bits` scans of
+ *   `channel` as integers and decimates it. The result is always scaled to
+ *   `THERM_SAMPLE_BITS` bits so the rest of the math doesn't care how much
+ *   we oversampled.
+ */
+static uint16_t therm_decimate(const uint16_t * scans, uint8_t channel)
+{
+    uint32_t sum = 0;
+    uint32_t num_scans = THERM_BURST_SCANS(oversample_bits);
+
+    for (uint32_t i = channel; i < num_scans * NUM_ADC_CHANNELS; i += NUM_ADC_CHANNELS) {
+        sum += scans[i];
+    }
+    // sum has 12 + 2n bits, n of which are real resolution
+    sum >>= oversample_bits;
+    return (uint16_t)(sum << (THERM_MAX_OVERSAMPLE_BITS - oversample_bits));
+}
+
+/*! Private function that gets called from the ADC interrupt once it's done converting
+ *   all thermocouple values. Decimates the `num_samples` bursts sitting in
+ *   `scans` and queues them up for the main loop. No conversion math happens here.
+ */
+static void therm_ADC_done(const uint16_t * scans, uint16_t num_samples)
+{
+    therm_sample_t sample;
+    uint32_t burst_len = THERM_BURST_SCANS(oversample_bits) * NUM_ADC_CHANNELS;
+
+    sample.timestamp = HAL_GetTick();
+    for (uint16_t i = 0; i < num_samples; i++) {
+        sample.seq = sample_seq++;
+        sample.vout = therm_decimate(&scans[i * burst_len], ADC_SCAN_VOUT);
+        sample.vref = therm_decimate(&scans[i * burst_len], ADC_SCAN_VREF);
+#if ADC_SCAN_DIE_TEMP
+        sample.die = therm_decimate(&scans[i * burst_len], ADC_SCAN_DIE);
+#else
+        sample.die = 0;
+#endif
+        (void)sampleq_push(&sample_queue, &sample);  // drops are spotted by seq
+    }
+
+    if (!keep_converting) {
+        // Only one reading. Let the main loop know we're done
         ADC_running = false;
     }
 }
 
+/*! Drains every queued sample into the window of readings, in batches. Spikes
+ *   are knocked out first, then continuous readings are decimated to reject
+ *   the mains (if set) and go through the IIR filter.
+ *   Returns how many samples it processed. Called by `therm_valueReady`, so
+ *   there's normally no need to call it directly.
+ */
+uint32_t therm_process(void)
+{
+    therm_sample_t batch[THERM_PROCESS_BATCH];
+    int32_t values[THERM_PROCESS_BATCH];
+    uint32_t num_popped;
+    uint32_t num_out;
+    uint32_t total = 0;
+    uint32_t last_tick = 0;
+    stats_t * dest;
+
+    if (start_pending && therm_settled()) {
+        // The front end is ready for the reading we put off
+        start_pending = false;
+        therm_startReading(pending_type);
+    }
+
+    dest = (reading_type == kThermReading_Adaptive) ? &adaptive : &readings;
+    do {
+        num_popped = sampleq_pop(&sample_queue, batch, sizeof(batch) / sizeof(batch[0]));
+        for (uint32_t i = 0; i < num_popped; i++) {
+            // Every sample has a sequence number, so gaps mean we missed some
+            missed_samples += batch[i].seq - (last_seq + 1);
+            last_seq = batch[i].seq;
+            last_tick = batch[i].timestamp;
+            therm_coldJunction(batch[i].die, batch[i].vref);
+            values[i] = median_filter(&despike,
+                                      therm_countsToCentiC(batch[i].vout, batch[i].vref));
+        }
+        // Only a continuous stream is evenly spaced enough to filter
+        num_out = num_popped;
+        if (reading_type == kThermReading_Continuous) {
+            num_out = filter_decimProcess(&mains_notch, values, num_popped);
+            filter_process(&smoothing, values, num_out);
+        }
+        for (uint32_t i = 0; i < num_out; i++) {
+            stats_push(dest, values[i]);
+        }
+        total += num_popped;
+    } while (num_popped != 0);
+    if (total != 0) {
+        despike_tick = last_tick;
+    }
+
+    if (total == 0 || reading_ready) {
+        return total;
+    }
+    if (reading_type == kThermReading_Adaptive) {
+        // Done once s^2 / n < target^2, i.e. the standard error is small enough.
+        //   s^2 is the sample variance, n / (n - 1) times the window's population
+        //   one, so that's var < target^2 * (n - 1). 64 bits, since target^2
+        //   alone can be near 2^32.
+        uint16_t n = stats_count(&adaptive);
+        if (n >= adaptive_min &&
+            ((uint64_t)stats_variance(&adaptive) < (uint64_t)adaptive_target_var * (n - 1) ||
+             stats_full(&adaptive))) {
+            float var = (float)stats_variance(&adaptive) / (n - 1);
+
+            therm_stopReading();
+            therm_discardQueued();
+            stats_push(&readings, stats_mean(&adaptive));
+            tracker_update(&trend, stats_mean(&adaptive),
+                           var > THERM_MIN_READING_VAR ? var : THERM_MIN_READING_VAR, last_tick);
+            last_conversions = n;
+            total_conversions += n;
+            reading_ready = true;
+        }
+    } else if (!keep_converting) {
+        // Our single reading came in
+        tracker_update(&trend, stats_latest(&readings), THERM_SINGLE_READING_VAR, last_tick);
+        reading_ready = true;
+    } else if (stats_full(&readings)) {
+        // We've had enough readings to get a valid, averaged temperature
+        reading_ready = true;
+    }
+    return total;
+}
+
+/*! Forgets the temperature trend, say after the oven's been idle for a while.
+ *   The next single or adaptive reading starts it over.
+ */
+void therm_resetTracker(void)
+{
+    tracker_reset(&trend);
+}
+
+/*! Returns true once a reading has gone into the temperature trend.
+ */
+bool therm_trackerValid(void)
+{
+    return tracker_valid(&trend);
+}
+
+/*! Returns the temperature right now, in centi-degrees celsius, extrapolated
+ *   from the readings so far along the trend. Good between readings.
+ */
+int32_t therm_getEstimate_cC(void)
+{
+    therm_process();
+    return tracker_estimate(&trend, HAL_GetTick());
+}
+
+/*! Returns how fast the temperature is rising, in centi-degrees celsius per
+ *   second.
+ */
+int32_t therm_getSlope_cC(void)
+{
+    return tracker_slope(&trend);
+}
+
+/*! Returns the standard deviation of `therm_getEstimate_cC` right now, in
+ *   centi-degrees celsius. Grows the longer it's been since the last reading.
+ */
+uint32_t therm_getUncertainty_cC(void)
+{
+    return tracker_uncertainty(&trend, HAL_GetTick());
+}
+
+/*! Returns how many ms from the last reading the estimate stays within
+ *   `max_uncertainty` centi-degrees (one standard deviation), up to
+ *   `limit_ms`. Use it to decide when the next reading is due.
+ */
+uint32_t therm_timeUntilUncertain_ms(uint32_t max_uncertainty, uint32_t limit_ms)
+{
+    return tracker_timeUntil(&trend, max_uncertainty, limit_ms);
+}
+
+/*! Private function that throws away samples that came in after a reading
+ *   was stopped, keeping track of their sequence numbers.
+ */
+static void therm_discardQueued(void)
+{
+    therm_sample_t sample;
+
+    while (sampleq_pop(&sample_queue, &sample, 1) != 0) {
+        last_seq = sample.seq;
+    }
+}
+
+/*! Returns how many conversions (decimated samples) the last adaptive reading
+ *   took.
+ */
+uint16_t therm_lastConversionCount(void)
+{
+    return last_conversions;
+}
+
+/*! Returns how many conversions every adaptive reading so far took, in total.
+ */
+uint32_t therm_totalConversionCount(void)
+{
+    return total_conversions;
+}
+
+/*! Returns how many samples were thrown out as spikes since the last reading
+ *   started.
+ */
+uint32_t therm_rejectedSamples(void)
+{
+    return median_rejected(&despike) - despike_base;
+}
+
+/*! Returns how many samples never made it to the window because the main loop
+ *   didn't drain the queue in time.
+ */
+uint32_t therm_missedSamples(void)
+{
+    return missed_samples;
+}
+
 /*! Returns true if there is a valid reading ready, either single if not doing
  *   continuous readings, else enough to get an averaged result
  */
 bool therm_valueReady(void) {
+    therm_process();
     return reading_ready;
 }
 
-/*! Returns true if the ADC is currently reading data in. Not currently used.
+/*! Returns true if the ADC is currently reading data in, is waiting on the
+ *   analog front end to settle before it starts, or its samples haven't been
+ *   processed yet.
  */
 bool therm_ADCRunning(void) {
-    return ADC_running;
+    return ADC_running || start_pending || sampleq_count(&sample_queue) != 0;
 }
 
 /*! Gets a reading from the thermocouple, returning
- *  the value in celsius with averaging over time.
+ *  the value in centi-degrees celsius with averaging over time.
  */
-float therm_getValue_averaged(void)
+int32_t therm_getValue_averaged_cC(void)
+{
+    return stats_mean(&readings);
+}
+
+/*! Gets a reading from the thermocouple, returning
+ *  the value in centi-degrees celsius. No averaging!
+ */
+int32_t therm_getValue_single_cC(void)
+{
+    reading_ready = false;
+    return stats_latest(&readings);
+}
+
+/*! Returns the cold junction temperature the readings are being compensated
+ *   for, in centi-degrees celsius: the die temperature, smoothed, or the one
+ *   the conversion table was made for if there's no die reading (yet).
+ */
+int32_t therm_getColdJunction_cC(void)
 {
-    float sensor, v1_25, vout = 0;
+    if (!cold_junction_valid) {
+        return THERM_COLD_JUNCTION_CC;
+    }
+    return cold_junction >> THERM_CJC_SMOOTHING_SHIFT;
+}
+
+/*! Records one point of a two-point calibration: a reading of `measured`
+ *   centi-degrees taken just now (with whatever calibration was set) while the
+ *   probe was at a known `reference`. Do it right after the reading, so the
+ *   cold junction is the one it was taken with.
+ */
+void therm_captureCalPoint(int32_t reference, int32_t measured, therm_cal_point_t * point)
+{
+    point->raw = therm_uncalibrate((int32_t)therm_centiCToRatio(measured) - cjc_ratio);
+    point->target = (int32_t)therm_centiCToRatio(reference) - cjc_ratio;
+}
+
+/*! Works out the gain and offset that put both captured points right, for
+ *   `therm_setCalibration` or the calibration record. Returns RET_CAL_ERR if
+ *   the points are too close together to trust, or it comes out too far off
+ *   to be real.
+ */
+ret_t therm_solveCalibration(const therm_cal_point_t * low, const therm_cal_point_t * high,
+                             int32_t * gain, int32_t * offset)
+{
+    int32_t span = high->raw - low->raw;
+    int64_t g;
+    int32_t o;
 
-    // Gather the readings and average them
-    for (int8_t i = NUM_READINGS - 1; i >= 0; i--) {
-        sensor += vout_readings[i];
-        v1_25 += vref_readings[i];
+    if (span < THERM_CAL_MIN_SPAN && span > -THERM_CAL_MIN_SPAN) {
+        return RET_CAL_ERR;
     }
+    g = ((int64_t)(high->target - low->target) << THERM_CAL_GAIN_SHIFT) / span;
+    if (g < THERM_CAL_MIN_GAIN || g > THERM_CAL_MAX_GAIN) {
+        return RET_CAL_ERR;
+    }
+    o = low->target - (int32_t)(((int64_t)low->raw * g) >> THERM_CAL_GAIN_SHIFT);
+    if (o < -THERM_CAL_MAX_OFFSET || o > THERM_CAL_MAX_OFFSET) {
+        return RET_CAL_ERR;
+    }
+    *gain = (int32_t)g;
+    *offset = o;
+    return RET_OK;
+}
 
-    // Normalize and send out
-    sensor = sensor / NUM_READINGS;
-    v1_25 = v1_25 / NUM_READINGS;
-    vout = sensor * (1.25f / v1_25);
-    return (vout - 1.25f) / 0.005f;
+/*! Gives access to the window of readings (in centi-degrees celsius) for
+ *   variance, min, max and such. Don't hold on to it across readings.
+ */
+const stats_t * therm_getStats(void)
+{
+    return &readings;
 }
 
-/*! Gets a reading from the thermocouple, returning
- *  the value in celsius. No averaging!
+/*! Float version of `therm_getValue_averaged_cC`, in celsius.
  */
-float therm_getValue_single(void)
+float therm_getValue_averaged(void)
 {
-    float sensor = vout_readings[THERM_GET_IDEX()];
-    float v1_25 = vref_readings[THERM_GET_IDEX()];
+    return (float)therm_getValue_averaged_cC() / 100.0f;
+}
 
-    // Normalize and send out
-    float vout = sensor * (1.25f / v1_25);
-    reading_ready = false;
-    return (vout - 1.25f) / 0.005f;
+/*! Float version of `therm_getValue_single_cC`, in celsius. No averaging!
+ */
+float therm_getValue_single(void)
+{
+    return (float)therm_getValue_single_cC() / 100.0f;
 }
 
 
 /****** ADC Callback functions *********/
 
 
-/*! The calback from the ADC interrupt that fires each time it converts
- *  a channel, then stores it in `pending_readings`. Also keeps track if all channels
- *  are done converting and modifies the flags `ADC_running`.
+/*! The callback from the DMA half transfer interrupt. For continuous readings
+ *  the first block of `pending_readings` is full and the DMA has moved on to
+ *  the second.
  */
-void HAL_ADC_ConvCpltCallback(ADC_HandleTypeDef* hadc)
+void HAL_ADC_ConvHalfCpltCallback(ADC_HandleTypeDef* hadc)
 {
-    // Get the readings
-    static uint8_t pending_index = 0;
-    bool start_reading = false;
-    pending_readings[pending_index] = HAL_ADC_GetValue(hadc);
-    pending_index++;
-    if (pending_index == NUM_ADC_CHANNELS) {
-        if (keep_converting) {
-            // kick off another reading!
-            start_reading = true;
-        }
-        // update state
-        ADC_running = keep_converting;
-        pending_index = 0;
-        therm_ADC_done();
-    } else {
-        ADC_running = true;
-        start_reading = true;
+    (void)hadc;
+    if (keep_converting) {
+        therm_ADC_done(pending_readings, running_block);
     }
+}
+
+/*! The callback from the DMA transfer complete interrupt. Fires once per single
+ *  reading, after everything has been stored in `pending_readings`. For
+ *  continuous readings the second block is full and the DMA has wrapped back
+ *  around to the first.
+ */
+void HAL_ADC_ConvCpltCallback(ADC_HandleTypeDef* hadc)
+{
+    (void)hadc;
 
-    // kick off another reading if requested
-    if (start_reading) {
-        HAL_StatusTypeDef ret;
-        ret = HAL_ADC_Start_IT(&hadc1);
-        if (ret != HAL_OK) {
-            Error_Handler_withRetval(ret);
+    if (keep_converting) {
+        uint32_t block_len = running_block * THERM_BURST_SCANS(oversample_bits) * NUM_ADC_CHANNELS;
+        therm_ADC_done(&pending_readings[block_len], running_block);
+    } else {
+        // Stop the ADC (and the burst clock, if it was oversampling) and clear
+        //   its DMA mode so the next scan can re-arm the stream.
+        if (oversample_bits != 0) {
+            hw_TIM2_stop();
         }
+        hw_ADC_stopDMA();
+        therm_ADC_done(pending_readings, 1);
     }
 }
 
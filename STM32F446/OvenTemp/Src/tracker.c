@@ -0,0 +1,184 @@
+/*!
+ * @file    tracker.c
+ * @author  Tyler Holmes
+ * @date    16-Oct-2026
+ * @brief   Kalman filter tracking temperature and its rate of rise.
+ */
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "common.h"
+#include "tracker.h"
+
+//! Slope variance we start out with, (cdeg / s)^2. Anything from -3 to +3 C/s.
+#define TRACKER_INITIAL_SLOPE_VAR  (300.0f * 300.0f)
+
+
+// Private function definitions
+static float tracker_predictVar(const tracker_t * tracker, float dt);
+static uint32_t tracker_minVarTime_ms(const tracker_t * tracker);
+
+
+/*! Sets up `tracker` with the given process noise: how much the slope can
+ *   drift, in (centi-degrees / second)^2 per second.
+ */
+void tracker_init(tracker_t * tracker, float process_var)
+{
+    tracker->process_var = process_var;
+    tracker_reset(tracker);
+}
+
+/*! Forgets everything. The next measurement starts the track over.
+ */
+void tracker_reset(tracker_t * tracker)
+{
+    tracker->temp = 0;
+    tracker->slope = 0;
+    tracker->p00 = 0;
+    tracker->p01 = 0;
+    tracker->p11 = 0;
+    tracker->last_tick = 0;
+    tracker->initialized = false;
+}
+
+/*! Folds in a `measurement` (centi-degrees) with variance `measurement_var`
+ *   (centi-degrees^2) taken at `tick`.
+ */
+void tracker_update(tracker_t * tracker, int32_t measurement, float measurement_var, uint32_t tick)
+{
+    float dt, innovation, s, k0, k1;
+    float p00, p01, p11;
+
+    if (!tracker->initialized) {
+        tracker->temp = (float)measurement;
+        tracker->slope = 0;
+        tracker->p00 = measurement_var;
+        tracker->p01 = 0;
+        tracker->p11 = TRACKER_INITIAL_SLOPE_VAR;
+        tracker->last_tick = tick;
+        tracker->initialized = true;
+        return;
+    }
+
+    // Predict: x = F x, P = F P F' + Q, with F = [1 dt; 0 1]
+    dt = (float)(tick - tracker->last_tick) / 1000.0f;
+    p00 = tracker_predictVar(tracker, dt);
+    p01 = tracker->p01 + dt * tracker->p11 + tracker->process_var * dt * dt / 2;
+    p11 = tracker->p11 + tracker->process_var * dt;
+    tracker->temp += tracker->slope * dt;
+
+    // Update, with H = [1 0]
+    innovation = (float)measurement - tracker->temp;
+    s = p00 + measurement_var;
+    k0 = p00 / s;
+    k1 = p01 / s;
+    tracker->temp += k0 * innovation;
+    tracker->slope += k1 * innovation;
+    tracker->p00 = (1 - k0) * p00;
+    tracker->p01 = (1 - k0) * p01;
+    tracker->p11 = p11 - k1 * p01;
+    tracker->last_tick = tick;
+}
+
+/*! Returns true once the tracker has seen a measurement.
+ */
+bool tracker_valid(const tracker_t * tracker)
+{
+    return tracker->initialized;
+}
+
+/*! Returns the temperature, in centi-degrees, extrapolated out to `tick`.
+ */
+int32_t tracker_estimate(const tracker_t * tracker, uint32_t tick)
+{
+    float dt = (float)(tick - tracker->last_tick) / 1000.0f;
+    return (int32_t)lroundf(tracker->temp + tracker->slope * dt);
+}
+
+/*! Returns the rate of rise, in centi-degrees per second.
+ */
+int32_t tracker_slope(const tracker_t * tracker)
+{
+    return (int32_t)lroundf(tracker->slope);
+}
+
+/*! Returns the standard deviation of `tracker_estimate` at `tick`, in
+ *   centi-degrees.
+ */
+uint32_t tracker_uncertainty(const tracker_t * tracker, uint32_t tick)
+{
+    float dt = (float)(tick - tracker->last_tick) / 1000.0f;
+    return (uint32_t)lroundf(sqrtf(tracker_predictVar(tracker, dt)));
+}
+
+/*! Returns how many ms after the last measurement the uncertainty stays at or
+ *   below `max_uncertainty` centi-degrees, up to `limit_ms`. 0 if it's already
+ *   over (or there's been no measurement).
+ */
+uint32_t tracker_timeUntil(const tracker_t * tracker, uint32_t max_uncertainty, uint32_t limit_ms)
+{
+    float max_var = (float)max_uncertainty * (float)max_uncertainty;
+    uint32_t lo = 0;
+    uint32_t hi = limit_ms;
+
+    if (!tracker->initialized || tracker->p00 > max_var) {
+        return 0;
+    }
+    if (tracker_predictVar(tracker, (float)limit_ms / 1000.0f) <= max_var) {
+        return limit_ms;
+    }
+    /* The variance is a cubic in dt with non-negative dt^2 and dt^3 terms, so
+     *   it's convex from the last measurement on. With a negative covariance it
+     *   dips first, and only grows past the bottom of that dip. It's under
+     *   `max_var` at the start, so it's under it all the way to the bottom too:
+     *   start the bisection there, where it can only cross once.
+     */
+    lo = tracker_minVarTime_ms(tracker);
+    if (lo >= hi) {
+        return limit_ms;  // still dipping at the limit, so it's under there
+    }
+    while (hi - lo > 1) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        if (tracker_predictVar(tracker, (float)mid / 1000.0f) <= max_var) {
+            lo = mid;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+/*! Private function that returns when, in ms after the last measurement, the
+ *   temperature variance is lowest. That's 0 unless the covariance is
+ *   negative; then it's where the derivative,
+ *   2 p01 + 2 p11 dt + process_var dt^2, comes back up to 0.
+ */
+static uint32_t tracker_minVarTime_ms(const tracker_t * tracker)
+{
+    float dt;
+
+    if (tracker->p01 >= 0) {
+        return 0;
+    }
+    if (tracker->process_var > 0) {
+        dt = (-tracker->p11 + sqrtf(tracker->p11 * tracker->p11 -
+                                    2 * tracker->process_var * tracker->p01))
+             / tracker->process_var;
+    } else if (tracker->p11 > 0) {
+        dt = -tracker->p01 / tracker->p11;
+    } else {
+        return UINT32_MAX;  // never turns around
+    }
+    return dt * 1000.0f >= (float)UINT32_MAX ? UINT32_MAX : (uint32_t)(dt * 1000.0f);
+}
+
+/*! Private function that returns the temperature variance `dt` seconds after
+ *   the last measurement.
+ */
+static float tracker_predictVar(const tracker_t * tracker, float dt)
+{
+    return tracker->p00 + 2 * dt * tracker->p01 + dt * dt * tracker->p11
+           + tracker->process_var * dt * dt * dt / 3;
+}
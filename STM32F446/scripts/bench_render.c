@@ -0,0 +1,85 @@
+/*!
+ * @file    bench_render.c
+ * @author  Tyler Holmes
+ * @date    16-Oct-2026
+ * @brief   Host benchmark of the display renderer against the old float one.
+ *
+ *      Counts the readings the two render differently, then times each over
+ *      every reading the display can show, best of `BENCH_REPEATS`. `make bench` in OvenTemp builds and
+ *      runs it. On the board, `make DEBUG=1 RENDER_BENCHMARK=1` builds print
+ *      the same comparison in cycles at boot.
+ */
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "render.h"
+
+#define BENCH_PASSES   (50)
+#define BENCH_REPEATS  (9)   //!< best of, to keep other processes out of it
+
+//! Where every render goes, so the compiler can't throw them away
+static volatile uint32_t bench_sink;
+
+
+static double bench_seconds(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+static double bench_time(int use_float)
+{
+    render_frame_t frame;
+    double best = 0;
+
+    for (int repeat = 0; repeat < BENCH_REPEATS; repeat++) {
+        double start = bench_seconds();
+        double took;
+
+        for (int pass = 0; pass < BENCH_PASSES; pass++) {
+            for (uint32_t centi = 0; centi <= RENDER_MAX_CENTI; centi++) {
+                if (use_float) {
+                    render_float(centi * 0.01f, &frame);
+                } else {
+                    render_centi(centi, &frame);
+                }
+                bench_sink = frame.glyphs[0] ^ frame.glyphs[3] ^ frame.point;
+            }
+        }
+        took = bench_seconds() - start;
+        best = (repeat == 0 || took < best) ? took : best;
+    }
+    return best * 1e9 / ((double)BENCH_PASSES * (RENDER_MAX_CENTI + 1));
+}
+
+int main(void)
+{
+    render_frame_t table, old;
+    double table_ns, float_ns;
+    uint32_t mismatches = 0;
+
+    // Float rounding has the old way drop a hundredth here and there
+    //   (0.29 * 100 is 28.99...), so differences are counted, not fatal
+    for (uint32_t centi = 0; centi <= RENDER_MAX_CENTI; centi++) {
+        render_centi(centi, &table);
+        render_float(centi * 0.01f, &old);
+        if (memcmp(table.glyphs, old.glyphs, sizeof(table.glyphs)) != 0 ||
+            table.point != old.point) {
+            mismatches++;
+        }
+    }
+
+    float_ns = bench_time(1);
+    table_ns = bench_time(0);
+    printf("float: %.2f ns per render (%lu of %lu readings differ)\n", float_ns,
+           (unsigned long)mismatches, (unsigned long)(RENDER_MAX_CENTI + 1));
+    printf("table: %.2f ns per render (%.1fx)\n", table_ns, float_ns / table_ns);
+    return 0;
+}
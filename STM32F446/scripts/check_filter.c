@@ -0,0 +1,68 @@
+/*!
+ * @file    check_filter.c
+ * @author  Tyler Holmes
+ * @date    16-Oct-2026
+ * @brief   Host check of the mains decimator's start up.
+ *
+ *      Feeds constant inputs through the boxcar decimator for every power of
+ *      two factor from 2, in uneven chunks and across resets, and checks every
+ *      output comes out at that constant, the first one after a reset included.
+ *      `make check` in OvenTemp builds and runs it.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "filter.h"
+
+#define CHECK_SAMPLES  (5 * FILTER_DECIM_MAX_FACTOR + 3)
+
+
+int main(void)
+{
+    static const int32_t levels[] = {0, 1, 2730, -2730, (1L << 19) - 1};
+    q31_t taps[FILTER_DECIM_MAX_FACTOR];
+    filter_decim_t decim;
+    int failures = 0;
+
+    for (uint8_t factor = 2; factor <= FILTER_DECIM_MAX_FACTOR; factor *= 2) {
+        for (uint8_t i = 0; i < factor; i++) {
+            taps[i] = (q31_t)(0x80000000UL / factor);
+        }
+        if (filter_decimInit(&decim, taps, factor) != RET_OK) {
+            printf("factor %u: init failed\n", factor);
+            failures++;
+            continue;
+        }
+
+        // Each level follows a reset, so the history holds the last one
+        for (uint32_t l = 0; l < sizeof(levels) / sizeof(levels[0]); l++) {
+            uint32_t fed = 0;
+            uint32_t chunk = 1;
+
+            filter_decimReset(&decim);
+            while (fed < CHECK_SAMPLES) {
+                int32_t samples[FILTER_DECIM_MAX_FACTOR];
+                uint32_t num_in = chunk < CHECK_SAMPLES - fed ? chunk : CHECK_SAMPLES - fed;
+                uint32_t num_out;
+
+                for (uint32_t i = 0; i < num_in; i++) {
+                    samples[i] = levels[l];
+                }
+                num_out = filter_decimProcess(&decim, samples, num_in);
+                for (uint32_t i = 0; i < num_out; i++) {
+                    if (samples[i] != levels[l]) {
+                        if (failures++ < 10) {
+                            printf("factor %u level %ld sample %lu: got %ld\n", factor,
+                                   (long)levels[l], (unsigned long)(fed + i), (long)samples[i]);
+                        }
+                    }
+                }
+                fed += num_in;
+                chunk = chunk % (FILTER_DECIM_MAX_FACTOR - 2) + 3;
+            }
+        }
+    }
+    printf("filter: %s\n", failures ? "FAILED" : "ok");
+    return failures != 0;
+}
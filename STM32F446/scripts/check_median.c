@@ -0,0 +1,102 @@
+/*!
+ * @file    check_median.c
+ * @author  Tyler Holmes
+ * @date    16-Oct-2026
+ * @brief   Host check of the sliding window Hampel filter against brute force.
+ *
+ *      Pushes ramps, a flat line with spikes and pseudo random samples (with
+ *      plenty of repeats) through every window length up to
+ *      `MEDIAN_MAX_WINDOW`, across a reset, and compares every output and the
+ *      median with ones worked out by sorting the window from scratch.
+ *      `make check` in OvenTemp builds and runs it.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "median.h"
+
+#define CHECK_PUSHES     (4 * MEDIAN_MAX_WINDOW + 5)
+#define CHECK_THRESHOLD  (30)
+#define CHECK_MIN_DEV    (5)
+
+
+static int32_t check_sample(int pattern, int i)
+{
+    static uint32_t lcg = 12345;
+
+    lcg = lcg * 1103515245UL + 12345;
+    switch (pattern) {
+        case 0:  return i;
+        case 1:  return -3 * i;
+        case 2:  return (lcg >> 16) % 9 == 0 ? 1000 : 100 + (int32_t)((lcg >> 20) % 3);
+        default: return (int32_t)((lcg >> 16) % 40) - 20;
+    }
+}
+
+//! The `rank`-th smallest of `values`, by insertion sorting a copy
+static int32_t check_rank(const int32_t * values, int n, int rank)
+{
+    int32_t sorted[MEDIAN_MAX_WINDOW];
+
+    for (int i = 0; i < n; i++) {
+        int j = i;
+        while (j > 0 && sorted[j - 1] > values[i]) {
+            sorted[j] = sorted[j - 1];
+            j--;
+        }
+        sorted[j] = values[i];
+    }
+    return sorted[rank];
+}
+
+//! What `median_filter` should give for `sample`, with `n` samples before it
+static int32_t check_expected(const int32_t * window, int n, int32_t sample)
+{
+    int32_t median, iqr;
+    int64_t deviation;
+
+    if (n < 3) {
+        return sample;
+    }
+    median = check_rank(window, n, n / 2);
+    iqr = check_rank(window, n, (3 * n) / 4) - check_rank(window, n, n / 4);
+    deviation = sample > median ? (int64_t)sample - median : (int64_t)median - sample;
+    if (deviation > CHECK_MIN_DEV &&
+        deviation * 10 * 256 > (int64_t)CHECK_THRESHOLD * iqr * 190) {
+        return median;
+    }
+    return sample;
+}
+
+int main(void)
+{
+    static int32_t pushed[CHECK_PUSHES];
+    median_t filter;
+    int failures = 0;
+
+    for (uint16_t window = 3; window <= MEDIAN_MAX_WINDOW; window++) {
+        median_init(&filter, window, CHECK_THRESHOLD, CHECK_MIN_DEV);
+        for (int pattern = 0; pattern < 4; pattern++) {
+            median_reset(&filter);
+            for (int i = 0; i < CHECK_PUSHES; i++) {
+                int first = i > window ? i - window : 0;
+                int32_t expected, got;
+
+                pushed[i] = check_sample(pattern, i);
+                expected = check_expected(&pushed[first], i - first, pushed[i]);
+                got = median_filter(&filter, pushed[i]);
+                first = i + 1 > window ? i + 1 - window : 0;
+                if (got != expected ||
+                    median_get(&filter) != check_rank(&pushed[first], i + 1 - first, (i + 1 - first) / 2)) {
+                    if (failures++ < 10) {
+                        printf("window %u pattern %d push %d: got %ld (%ld)\n",
+                               window, pattern, i, (long)got, (long)expected);
+                    }
+                }
+            }
+        }
+    }
+    printf("median: %s\n", failures ? "FAILED" : "ok");
+    return failures != 0;
+}
@@ -0,0 +1,72 @@
+/*!
+ * @file    check_stats.c
+ * @author  Tyler Holmes
+ * @date    16-Oct-2026
+ * @brief   Host check of the sliding window statistics against brute force.
+ *
+ *      Pushes ramps (up and down) and pseudo random samples through every
+ *      window length up to `STATS_MAX_WINDOW`, including a full
+ *      `STATS_MAX_WINDOW` window, and compares the mean, min and max with
+ *      ones worked out from scratch. `make check` in OvenTemp builds and
+ *      runs it.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "stats.h"
+
+#define CHECK_PUSHES  (3 * STATS_MAX_WINDOW + 7)
+
+
+static int32_t check_sample(int pattern, int i)
+{
+    static uint32_t lcg = 12345;
+
+    switch (pattern) {
+        case 0:  return i;
+        case 1:  return -i;
+        default:
+            lcg = lcg * 1103515245UL + 12345;
+            return (int32_t)(lcg >> 16) % 2000 - 1000;
+    }
+}
+
+int main(void)
+{
+    static int32_t pushed[CHECK_PUSHES];
+    stats_t stats;
+    int failures = 0;
+
+    for (uint16_t window = 1; window <= STATS_MAX_WINDOW; window++) {
+        for (int pattern = 0; pattern < 3; pattern++) {
+            stats_init(&stats, window);
+            for (int i = 0; i < CHECK_PUSHES; i++) {
+                int first = i + 1 > window ? i + 1 - window : 0;
+                int32_t lo, hi;
+                int64_t sum = 0;
+
+                pushed[i] = check_sample(pattern, i);
+                stats_push(&stats, pushed[i]);
+
+                lo = hi = pushed[first];
+                for (int j = first; j <= i; j++) {
+                    lo = pushed[j] < lo ? pushed[j] : lo;
+                    hi = pushed[j] > hi ? pushed[j] : hi;
+                    sum += pushed[j];
+                }
+                if (stats_min(&stats) != lo || stats_max(&stats) != hi ||
+                    stats_mean(&stats) != (int32_t)(sum / (i + 1 - first)) ||
+                    stats.min.len > window || stats.max.len > window) {
+                    if (failures++ < 10) {
+                        printf("window %u pattern %d push %d: min %ld (%ld) max %ld (%ld)\n",
+                               window, pattern, i, (long)stats_min(&stats), (long)lo,
+                               (long)stats_max(&stats), (long)hi);
+                    }
+                }
+            }
+        }
+    }
+    printf("stats: %s\n", failures ? "FAILED" : "ok");
+    return failures != 0;
+}
@@ -0,0 +1,361 @@
+"""
+Generates the firmware's constant tables (filter coefficients, conversion
+constants, cycle detector tables) from a single calibration description, so
+nothing has to be worked out at boot or per sample.
+
+    $ python3 gen_tables.py [calibration.json]
+
+writes OvenTemp/Inc/tables.h and OvenTemp/Src/tables.c. `make tables` in
+OvenTemp runs it. The output is checked in, so building doesn't need Python.
+"""
+import argparse
+import json
+import math
+import os
+
+SCRIPT_DIR = os.path.dirname(os.path.abspath(__file__))
+PROJECT_DIR = os.path.join(SCRIPT_DIR, "..", "OvenTemp")
+
+Q31_ONE = 1 << 31
+FILTER_COEFFS_PER_STAGE = 5
+# Fractional bits of the vout / vref ratio the firmware indexes the table by
+RATIO_FRAC_BITS = 16
+
+# NIST ITS-90 type K reference functions: E in mV for t in C
+TYPE_K_BELOW_ZERO = [
+    0.0, 0.394501280250e-01, 0.236223735980e-04, -0.328589067840e-06,
+    -0.499048287770e-08, -0.675090591730e-10, -0.574103274280e-12,
+    -0.310888728940e-14, -0.104516093650e-16, -0.198892668780e-19,
+    -0.163226974860e-22,
+]
+TYPE_K_ABOVE_ZERO = [
+    -0.176004136860e-01, 0.389212049750e-01, 0.185587700320e-04,
+    -0.994575928740e-07, 0.318409457190e-09, -0.560728448890e-12,
+    0.560750590590e-15, -0.320207200030e-18, 0.971511471520e-22,
+    -0.121047212750e-25,
+]
+TYPE_K_EXPONENTIAL = (0.118597600000e+00, -0.118343200000e-03, 0.126968600000e+03)
+TYPE_K_RANGE = (-270.0, 1372.0)
+
+HEADER = """/*!
+ * @file    {name}
+ * @author  Tyler Holmes
+ * @date    16-Oct-2026
+ * @brief   {brief}
+ *
+ *      Generated by scripts/gen_tables.py from scripts/{source}. Don't edit,
+ *      change the description and run `make tables` instead.
+ */
+"""
+
+
+def butterworth_lowpass(order, corner_fraction):
+    """
+    Biquads of a Butterworth low pass with its corner at `corner_fraction` of
+    the sample rate, by the bilinear transform. Returns a list of
+    (b0, b1, b2, a1, a2), with a0 normalized to 1.
+    """
+    if order < 2 or order % 2:
+        raise ValueError("smoothing order must be even and at least 2")
+    if not 0 < corner_fraction < 0.5:
+        raise ValueError("smoothing corner must be below Nyquist")
+
+    k = math.tan(math.pi * corner_fraction)
+    stages = []
+    for i in range(order // 2):
+        q = 1 / (2 * math.sin(math.pi * (2 * i + 1) / (2 * order)))
+        norm = 1 / (1 + k / q + k * k)
+        b0 = k * k * norm
+        stages.append((b0, 2 * b0, b0, 2 * (k * k - 1) * norm, (1 - k / q + k * k) * norm))
+    return stages
+
+
+def to_cmsis_q31(stages):
+    """
+    Scales biquads into CMSIS q31 order (b0, b1, b2, -a1, -a2), shifted down
+    until every coefficient fits. Each stage's b1 is trimmed so its DC gain
+    is exactly one in integers, which `filter_process` relies on when it
+    primes the state. Returns (coefficients, post shift).
+    """
+    largest = max(abs(c) for stage in stages for c in stage)
+    shift = 0
+    while largest >= (1 << shift):
+        shift += 1
+
+    scale = Q31_ONE >> shift
+    coeffs = []
+    for b0, b1, b2, a1, a2 in stages:
+        q = [round(b0 * scale), round(b1 * scale), round(b2 * scale),
+             round(-a1 * scale), round(-a2 * scale)]
+        # unity DC gain: b0 + b1 + b2 == 1 - (-a1) - (-a2), in q31 >> shift
+        q[1] += scale - q[3] - q[4] - (q[0] + q[1] + q[2])
+        coeffs.extend(q)
+    return coeffs, shift
+
+
+def type_k_mv(t):
+    """ Type K thermocouple voltage, in mV, with its reference junction at 0 C. """
+    if t < 0:
+        return sum(d * t ** i for i, d in enumerate(TYPE_K_BELOW_ZERO))
+    a0, a1, a2 = TYPE_K_EXPONENTIAL
+    return (sum(c * t ** i for i, c in enumerate(TYPE_K_ABOVE_ZERO)) +
+            a0 * math.exp(a1 * (t - a2) ** 2))
+
+
+def amplifier_vout(amp, t):
+    """
+    Amp output with the measuring junction at `t` C. An AD8495 style amp
+    multiplies the thermocouple voltage, which is relative to the cold
+    junction, then adds its reference and its own linear (cjc_v_per_c)
+    cold junction compensation.
+    """
+    cold = amp["cold_junction_c"]
+    return (amp["reference_v"] + amp["gain"] * (type_k_mv(t) - type_k_mv(cold)) / 1000 +
+            amp["cjc_v_per_c"] * cold)
+
+
+def amplifier_temperature(amp, vout):
+    """ Inverse of `amplifier_vout`, by bisection. It's monotonic over the range. """
+    lo, hi = TYPE_K_RANGE
+    for _ in range(100):
+        mid = (lo + hi) / 2
+        if amplifier_vout(amp, mid) < vout:
+            lo = mid
+        else:
+            hi = mid
+    return (lo + hi) / 2
+
+
+def lut_lookup(lut, start, shift, ratio):
+    """ What the firmware does with the table: integer index, linear interpolation. """
+    offset = ratio - start
+    index = min(max(offset >> shift, 0), len(lut) - 2)
+    frac = offset - (index << shift)
+    return lut[index] + (((lut[index + 1] - lut[index]) * frac) >> shift)
+
+
+def conversion(cal):
+    """
+    Ratiometric conversion: the ADC converts the amp's reference alongside its
+    output, so the table maps vout / vref (q16) to centi-degrees. Entries are
+    evenly spaced in the ratio so the firmware can index it with a shift.
+    Returns (table, first ratio, vref counts), and checks the interpolation
+    error over the described range.
+    """
+    amp = cal["amplifier"]
+    adc = cal["adc"]
+    tc = cal["thermocouple"]
+    if tc["type"] != "K":
+        raise ValueError("only type K thermocouples are described")
+
+    one = 1 << RATIO_FRAC_BITS
+    step = 1 << tc["segment_shift"]
+    ratio_lo = amplifier_vout(amp, tc["min_c"]) / amp["reference_v"] * one
+    ratio_hi = amplifier_vout(amp, tc["max_c"]) / amp["reference_v"] * one
+    start = int(math.floor(ratio_lo / step)) * step
+    size = int(math.ceil((ratio_hi - start) / step)) + 1
+    lut = [round(100 * amplifier_temperature(amp, amp["reference_v"] * (start + i * step) / one))
+           for i in range(size)]
+
+    worst = 0
+    t = tc["min_c"]
+    while t <= tc["max_c"]:
+        ratio = int(amplifier_vout(amp, t) / amp["reference_v"] * one)
+        worst = max(worst, abs(lut_lookup(lut, start, tc["segment_shift"], ratio) - 100 * t))
+        t += 0.25
+    print("Conversion table: {} entries, worst interpolation error {:.2f} C".format(
+        size, worst / 100))
+
+    vref_counts = round(amp["reference_v"] / adc["supply_v"] * ((1 << adc["bits"]) - 1))
+    return lut, start, vref_counts
+
+
+def cold_junction(cal):
+    """
+    Cold junction compensation: what to add to the q16 vout / vref ratio, with
+    the cold junction at each temperature of the table, to get the ratio the
+    conversion table expects (the cold junction at `cold_junction_c`). The
+    thermocouple voltage drops by however much its curve rises between the
+    two, and the amp's own compensation makes up a straight line's worth of
+    it. Returns (table, first temperature, step), temperatures in cC.
+    """
+    amp = cal["amplifier"]
+    cj = cal["cold_junction"]
+    nominal = amp["cold_junction_c"]
+    one = 1 << RATIO_FRAC_BITS
+
+    table = []
+    t = cj["min_c"]
+    while t <= cj["max_c"] + 1e-9:
+        volts = (amp["gain"] * (type_k_mv(t) - type_k_mv(nominal)) / 1000 -
+                 amp["cjc_v_per_c"] * (t - nominal))
+        table.append(round(volts / amp["reference_v"] * one))
+        t += cj["step_c"]
+    return table, round(100 * cj["min_c"]), round(100 * cj["step_c"])
+
+
+def format_array(values, fmt, per_line):
+    lines = []
+    for i in range(0, len(values), per_line):
+        lines.append("    " + ", ".join(fmt(v) for v in values[i:i + per_line]) + ",")
+    return "\n".join(lines)
+
+
+def fmt_float(value):
+    return "{:.9e}f".format(value)
+
+
+def generate(cal, source):
+    lut, lut_start, vref_counts = conversion(cal)
+    cjc, cjc_start, cjc_step = cold_junction(cal)
+    amp = cal["amplifier"]
+    tc = cal["thermocouple"]
+
+    smoothing = cal["smoothing"]
+    filter_coeffs, filter_shift = to_cmsis_q31(
+        butterworth_lowpass(smoothing["order"], smoothing["corner_fraction"]))
+    filter_stages = len(filter_coeffs) // FILTER_COEFFS_PER_STAGE
+
+    mains_factor = cal["mains"]["samples_per_cycle"]
+    # 1 / factor each. Only the sum of all of them would overflow q31.
+    mains_taps = [Q31_ONE // mains_factor] * mains_factor
+
+    cycle = cal["cycle"]
+    block = cycle["block"]
+    bins = range(cycle["min_bin"], cycle["max_bin"] + 1)
+    goertzel = [2 * math.cos(2 * math.pi * k / block) for k in bins]
+    hann = [0.5 - 0.5 * math.cos(2 * math.pi * i / block) for i in range(block)]
+
+    header = HEADER.format(name="tables.h", source=source,
+                           brief="Constant tables generated from the calibration description.")
+    header += """#pragma once
+
+#include <stdint.h>
+
+//! Fractional bits of the vout / vref ratio `therm_ratio_lut` is indexed by
+#define THERM_RATIO_FRAC_BITS  ({frac_bits})
+/*! `therm_ratio_lut` covers {min_c:g} to {max_c:g} C in segments of
+ *   2^`THERM_LUT_SEGMENT_SHIFT` of ratio, starting at `THERM_LUT_RATIO_START`.
+ */
+#define THERM_LUT_RATIO_START    ({lut_start}UL)
+#define THERM_LUT_SEGMENT_SHIFT  ({shift})
+#define THERM_LUT_SIZE           ({lut_size})
+
+//! Cold junction temperature `therm_ratio_lut` was made for, in centi-degrees
+#define THERM_COLD_JUNCTION_CC  ({cold_cc})
+//! `therm_cjc_ratio` starts at `THERM_CJC_START_CC` and steps by `THERM_CJC_STEP_CC`
+#define THERM_CJC_START_CC  ({cjc_start})
+#define THERM_CJC_STEP_CC   ({cjc_step})
+#define THERM_CJC_SIZE      ({cjc_size})
+
+//! Raw {bits} bit counts of the {ref:g} V reference on a {supply:g} V supply. Used until we've seen one.
+#define THERM_NOMINAL_VREF_COUNTS  ({vref_counts})
+
+//! Samples per mains cycle, and how many get decimated down to one
+#define THERM_MAINS_SAMPLES_PER_CYCLE  ({mains_factor})
+
+//! Biquads in `therm_smoothing_filter`, and the post shift they're scaled by
+#define THERM_SMOOTHING_STAGES  ({filter_stages})
+#define THERM_SMOOTHING_SHIFT   ({filter_shift})
+
+//! Samples in each Goertzel block
+#define CYCLE_BLOCK       ({block})
+//! Lowest and highest Goertzel bins, in cycles per block
+#define CYCLE_MIN_BIN     ({min_bin})
+#define CYCLE_MAX_BIN     ({max_bin})
+#define CYCLE_BINS        (CYCLE_MAX_BIN - CYCLE_MIN_BIN + 1)
+
+
+extern const int32_t therm_ratio_lut[THERM_LUT_SIZE];
+extern const int32_t therm_cjc_ratio[THERM_CJC_SIZE];
+extern const int32_t therm_smoothing_filter[THERM_SMOOTHING_STAGES * 5];
+extern const int32_t therm_mains_taps[THERM_MAINS_SAMPLES_PER_CYCLE];
+extern const float cycle_goertzel_coeffs[CYCLE_BINS];
+extern const float cycle_hann_window[CYCLE_BLOCK];
+""".format(frac_bits=RATIO_FRAC_BITS, min_c=tc["min_c"], max_c=tc["max_c"],
+           lut_start=lut_start, shift=tc["segment_shift"], lut_size=len(lut),
+           cold_cc=round(100 * amp["cold_junction_c"]), cjc_start=cjc_start,
+           cjc_step=cjc_step, cjc_size=len(cjc),
+           ref=amp["reference_v"], bits=cal["adc"]["bits"], supply=cal["adc"]["supply_v"],
+           vref_counts=vref_counts, mains_factor=mains_factor, filter_stages=filter_stages,
+           filter_shift=filter_shift, block=block, min_bin=cycle["min_bin"],
+           max_bin=cycle["max_bin"])
+
+    source_c = HEADER.format(name="tables.c", source=source,
+                             brief="Constant tables generated from the calibration description.")
+    source_c += """
+#include <stdint.h>
+
+#include "tables.h"
+
+
+/*! Temperature, in centi-degrees, at each vout / vref of
+ *   `THERM_LUT_RATIO_START` + (i << `THERM_LUT_SEGMENT_SHIFT`) (q{frac_bits}). The
+ *   type {tc_type} curve through a {gain:g}x amp with {cjc_mv:g} mV/C cold junction
+ *   compensation, the cold junction at {cold:g} C.
+ */
+const int32_t therm_ratio_lut[THERM_LUT_SIZE] = {{
+{lut}
+}};
+
+/*! Added to the q{frac_bits} vout / vref ratio to correct for the cold junction
+ *   being at `THERM_CJC_START_CC` + i * `THERM_CJC_STEP_CC` instead of
+ *   `THERM_COLD_JUNCTION_CC`: the type {tc_type} curve's rise over that, less
+ *   the amp's {cjc_mv:g} mV/C of its own compensation.
+ */
+const int32_t therm_cjc_ratio[THERM_CJC_SIZE] = {{
+{cjc}
+}};
+
+/*! Default smoothing for continuous readings: order {order} Butterworth low pass
+ *   with its corner at {corner:g} of the decimated sample rate. CMSIS order
+ *   (b0, b1, b2, -a1, -a2) per stage, q31 shifted down by
+ *   `THERM_SMOOTHING_SHIFT` to fit a1. Each b1 is trimmed for exactly unity
+ *   DC gain.
+ */
+const int32_t therm_smoothing_filter[THERM_SMOOTHING_STAGES * 5] = {{
+{filter}
+}};
+
+//! Boxcar taps for the mains decimator
+const int32_t therm_mains_taps[THERM_MAINS_SAMPLES_PER_CYCLE] = {{
+{mains}
+}};
+
+//! Goertzel 2cos(w) per bin, `CYCLE_MIN_BIN` first
+const float cycle_goertzel_coeffs[CYCLE_BINS] = {{
+{goertzel}
+}};
+
+//! Hann window over a Goertzel block
+const float cycle_hann_window[CYCLE_BLOCK] = {{
+{hann}
+}};
+""".format(frac_bits=RATIO_FRAC_BITS, tc_type=tc["type"], gain=amp["gain"],
+           cjc_mv=1000 * amp["cjc_v_per_c"], cold=amp["cold_junction_c"],
+           lut=format_array(lut, str, 8), cjc=format_array(cjc, str, 8),
+           order=smoothing["order"], corner=smoothing["corner_fraction"],
+           filter=format_array(filter_coeffs, str, FILTER_COEFFS_PER_STAGE),
+           mains=format_array(mains_taps, str, 8),
+           goertzel=format_array(goertzel, fmt_float, 4),
+           hann=format_array(hann, fmt_float, 4))
+    return header, source_c
+
+
+if __name__ == '__main__':
+    parser = argparse.ArgumentParser(description=__doc__.split("\n\n")[0])
+    parser.add_argument("calibration", nargs="?",
+                        default=os.path.join(SCRIPT_DIR, "calibration.json"))
+    parser.add_argument("--project", default=PROJECT_DIR,
+                        help="OvenTemp directory to write Inc/tables.h and Src/tables.c into")
+    args = parser.parse_args()
+
+    with open(args.calibration) as f:
+        cal = json.load(f)
+    header, source_c = generate(cal, os.path.basename(args.calibration))
+
+    for path, text in ((os.path.join(args.project, "Inc", "tables.h"), header),
+                       (os.path.join(args.project, "Src", "tables.c"), source_c)):
+        with open(path, "w") as f:
+            f.write(text)
+        print("Wrote {}".format(os.path.relpath(path)))